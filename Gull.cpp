@@ -11,6 +11,10 @@
 #undef HNI
 #endif
 
+#ifndef _WIN32
+#define POSIX_BUILD // Linux & co: fork()ed children, shared anonymous mappings, futex idling
+#endif
+
 #define CPU_TIMING
 #undef CPU_TIMING
 
@@ -19,7 +23,37 @@
 
 #include <iostream>
 #include "setjmp.h"
+#ifndef POSIX_BUILD
 #include "windows.h"
+#define Align64 __declspec(align(64))
+#define I64 "I64"
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <cpuid.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+#define __forceinline inline __attribute__((always_inline))
+#define Align64 __attribute__((aligned(64)))
+#define register // dropped by C++17
+#define _mm_popcnt_u64(x) __builtin_popcountll(x) // a popcnt instruction with -mpopcnt
+typedef int LONG;
+#define I64 "ll"
+#define random gull_random // <stdlib.h> has its own random()
+#endif
 #ifdef TUNER
 #include "time.h"
 
@@ -80,7 +114,7 @@ typedef long long sint64;
 #define SDiag(x) (File(x) + Rank(x))
 #define Dist(x,y) Max(Abs(Rank(x)-Rank(y)),Abs(File(x)-File(y)))
 #define VarC(var,me) ((me) ? (var##_b) : (var##_w))
-#define PVarC(prefix,var,me) ((me) ? (prefix##.##var##_b) : (prefix##.##var##_w))
+#define PVarC(prefix,var,me) ((me) ? (prefix.var##_b) : (prefix.var##_w))
 
 #define Bit(x) (Convert(1,uint64) << (x))
 #ifndef HNI
@@ -413,7 +447,7 @@ typedef struct {
 	uint64 bb[16];
 	uint8 square[64];
 } GBoard;
-__declspec(align(64)) GBoard Board[1];
+Align64 GBoard Board[1];
 uint64 Stack[2048];
 int sp, save_sp;
 uint64 nodes, check_node, check_node_smp;
@@ -436,7 +470,7 @@ typedef struct {
 	int margin, *start, *current;
 	int moves[230];
 } GData;
-__declspec(align(64)) GData Data[128];
+Align64 GData Data[128];
 GData *Current = Data;
 #define FlagSort (1 << 0)
 #define FlagNoBcSort (1 << 1)
@@ -478,11 +512,11 @@ typedef struct {
 } GPawnEntry;
 #ifndef TUNER
 #define pawn_hash_size (1024 * 1024)
-__declspec(align(64)) GPawnEntry PawnHash[pawn_hash_size];
+Align64 GPawnEntry PawnHash[pawn_hash_size];
 #else
 #define pawn_hash_size (32 * 1024)
-__declspec(align(64)) GPawnEntry PawnHashOne[pawn_hash_size];
-__declspec(align(64)) GPawnEntry PawnHashTwo[pawn_hash_size];
+Align64 GPawnEntry PawnHashOne[pawn_hash_size];
+Align64 GPawnEntry PawnHashTwo[pawn_hash_size];
 GPawnEntry * PawnHash = PawnHashOne;
 #endif
 #define pawn_hash_mask (pawn_hash_size - 1)
@@ -553,6 +587,7 @@ GMaterial * Material;
 #define FlagSingleBishop_b (1 << 1)
 #define FlagCallEvalEndgame_w (1 << 2)
 #define FlagCallEvalEndgame_b (1 << 3)
+#define FlagMaterialValid (1 << 7)
 
 #ifndef TUNER
 int Pst[16 * 64];
@@ -664,7 +699,9 @@ sint64 StartTime, InfoTime, CurrTime;
 uint16 SMoves[256];
 
 jmp_buf Jump, ResetJump;
+#ifndef POSIX_BUILD
 HANDLE StreamHandle; 
+#endif
 
 #define ExclSingle(depth) 8
 #define ExclDouble(depth) 16
@@ -955,7 +992,11 @@ const int KingAttackScale[16] = { 0, 1, 4, 9, 16, 25, 36, 49, 64, 64, 64, 64, 64
 #endif
 
 int PrN = 1, CPUs = 1, HT = 0, parent = 1, child = 0, WinParId, Id = 0, ResetHash = 1, NewPrN = 0;
+#ifndef POSIX_BUILD
 HANDLE ChildPr[MaxPrN];
+#else
+pid_t ChildPr[MaxPrN];
+#endif
 #define SplitDepth 10
 #define SplitDepthPV 4
 #define MaxSplitPoints 64 // mustn't exceed 64
@@ -1003,9 +1044,22 @@ GSMPI * Smpi;
 
 jmp_buf CheckJump;
 
+#ifndef POSIX_BUILD
 HANDLE SHARED = NULL, HASH = NULL;
+#else
+sint64 SharedSize = 0, HashSize = 0; // bytes mapped, 0 = none
+#endif
 
-#ifndef W32_BUILD
+#ifdef POSIX_BUILD
+#define SET_BIT(var,bit) (__atomic_fetch_or(&(var),1 << (bit),__ATOMIC_SEQ_CST))
+#define SET_BIT_64(var,bit) (__atomic_fetch_or(&(var),Bit(bit),__ATOMIC_SEQ_CST));
+#define ZERO_BIT_64(var,bit) (__atomic_fetch_and(&(var),~Bit(bit),__ATOMIC_SEQ_CST));
+#define TEST_RESET_BIT(var,bit) ((__atomic_fetch_and(&(var),~Bit(bit),__ATOMIC_SEQ_CST) >> (bit)) & 1)
+#define TEST_RESET(var) (__atomic_exchange_n(&(var),0,__ATOMIC_SEQ_CST))
+#define SET(var,value) (__atomic_exchange_n(&(var),value,__ATOMIC_SEQ_CST))
+#define InterlockedAdd64(var,value) (__atomic_add_fetch((var),(value),__ATOMIC_SEQ_CST))
+#define LOCK(lock) {while (__sync_val_compare_and_swap(&(lock),0,1)) _mm_pause();}
+#elif !defined(W32_BUILD)
 #define SET_BIT(var,bit) (InterlockedOr(&(var),1 << (bit)))
 #define SET_BIT_64(var,bit) (InterlockedOr64(&(var),Bit(bit)));
 #define ZERO_BIT_64(var,bit) (InterlockedAnd64(&(var),~Bit(bit)));
@@ -1018,9 +1072,10 @@ HANDLE SHARED = NULL, HASH = NULL;
 #define TEST_RESET_BIT(var,bit) (InterlockedBitTestAndReset(&(var),bit))
 #define TEST_RESET(var) (InterlockedExchange(&(var),0))
 #endif
+#ifndef POSIX_BUILD
 #define SET(var,value) (InterlockedExchange(&(var),value))
-
 #define LOCK(lock) {while (InterlockedCompareExchange(&(lock),1,0)) _mm_pause();}
+#endif
 #define UNLOCK(lock) {SET(lock,0);}
 
 // END SMP
@@ -1080,11 +1135,16 @@ void send_best_move();
 void get_position(char string[]);
 void get_time_limit(char string[]);
 sint64 get_time();
+#ifdef POSIX_BUILD
+void idle_wait(volatile long long * word);
+void idle_wake(volatile long long * word);
+#endif
 int time_to_stop(GSearchInfo * SI, int time, int searching);
 void check_time(int searching);
 void check_time(int time, int searching);
 int input();
 void uci();
+void check_state();
 
 #ifdef TUNER
 #ifndef RECORD_GAMES
@@ -2058,6 +2118,7 @@ loop:
 #endif
 
 #ifndef W32_BUILD
+#ifndef POSIX_BUILD
 __forceinline int lsb(uint64 x) {
 	register unsigned long y;
 	_BitScanForward64(&y, x);
@@ -2069,6 +2130,15 @@ __forceinline int msb(uint64 x) {
 	_BitScanReverse64(&y, x);
 	return y;
 }
+#else
+__forceinline int lsb(uint64 x) {
+	return __builtin_ctzll(x);
+}
+
+__forceinline int msb(uint64 x) {
+	return 63 ^ __builtin_clzll(x);
+}
+#endif
 
 __forceinline int popcnt(uint64 x) {
 	x = x - ((x >> 1) & 0x5555555555555555);
@@ -2482,8 +2552,10 @@ void init_eval() {
 
 void calc_material(int index) {
 	int pawns[2], knights[2], light[2], dark[2], rooks[2], queens[2], bishops[2], major[2], minor[2], tot[2], mat[2], mul[2], quad[2], score, phase, me, i = index;
+	GMaterial entry;
+	memset(&entry, 0, sizeof(GMaterial));
 #ifdef TUNER
-	Material[index].generation = generation;
+	entry.generation = generation;
 #endif
 	queens[White] = i % 3; i /= 3;
 	queens[Black] = i % 3; i /= 3;
@@ -2511,7 +2583,7 @@ void calc_material(int index) {
 	phase = Phase[PieceType[WhitePawn]] * (pawns[White] + pawns[Black]) + Phase[PieceType[WhiteKnight]] * (knights[White] + knights[Black])
 		+ Phase[PieceType[WhiteLight]] * (bishops[White] + bishops[Black]) + Phase[PieceType[WhiteRook]] * (rooks[White] + rooks[Black])
 		+ Phase[PieceType[WhiteQueen]] * (queens[White] + queens[Black]);
-	Material[index].phase = Min((Max(phase - PhaseMin, 0) * 128) / (PhaseMax - PhaseMin), 128);
+	entry.phase = Min((Max(phase - PhaseMin, 0) * 128) / (PhaseMax - PhaseMin), 128);
 
 	int special = 0;
 	for (me = 0; me < 2; me++) {
@@ -2530,7 +2602,7 @@ void calc_material(int index) {
 			else if ((major[opp] + minor[opp]) - (major[me] + minor[me]) >= 2) IncV(special, Ca(MatSpecial, MatQ3));
 		}
 	}
-	score += (Opening(special) * Material[index].phase + Endgame(special) * (128 - (int)Material[index].phase)) / 128;
+	score += (Opening(special) * entry.phase + Endgame(special) * (128 - (int)entry.phase)) / 128;
 
 	for (me = 0; me < 2; me++) {
 		quad[me] += pawns[me] * (pawns[me] * TrAv(MatQuadMe, 5, 0, 0) + knights[me] * TrAv(MatQuadMe, 5, 0, 1)
@@ -2597,31 +2669,64 @@ void calc_material(int index) {
 		mul[Black] = Min(mul[Black], 25);
 	}
 	for (me = 0; me < 2; me++) {
-		Material[index].mul[me] = mul[me];
-		Material[index].pieces[me] = major[me] + minor[me];
+		entry.mul[me] = mul[me];
+		entry.pieces[me] = major[me] + minor[me];
 	}
 	if (score > 0) score = (score * mat[White]) / 32;
 	else score = (score * mat[Black]) / 32;
-	Material[index].score = score;
+	entry.score = score;
 	for (me = 0; me < 2; me++) {
-		if (major[me] == 0 && minor[me] == bishops[me] && minor[me] <= 1) Material[index].flags |= VarC(FlagSingleBishop, me);
+		if (major[me] == 0 && minor[me] == bishops[me] && minor[me] <= 1) entry.flags |= VarC(FlagSingleBishop, me);
 		if (((major[me] == 0 || minor[me] == 0) && major[me] + minor[me] <= 1) || major[opp] + minor[opp] == 0
-			|| (!pawns[me] && major[me] == rooks[me] && major[me] == 1 && minor[me] == bishops[me] && minor[me] == 1 && rooks[opp] == 1 && !minor[opp] && !queens[opp])) Material[index].flags |= VarC(FlagCallEvalEndgame, me);
+			|| (!pawns[me] && major[me] == rooks[me] && major[me] == 1 && minor[me] == bishops[me] && minor[me] == 1 && rooks[opp] == 1 && !minor[opp] && !queens[opp])) entry.flags |= VarC(FlagCallEvalEndgame, me);
 	}
+#ifdef TUNER
+	Material[index] = entry;
+#else
+	entry.flags |= FlagMaterialValid;
+	uint64 u; memcpy(&u, &entry, sizeof(uint64));
+	*(volatile uint64*)(Material + index) = u; // single store: other processes never see a half-written entry
+#endif
 }
 
 void init_material() {
 #ifdef TUNER
 	Material = (GMaterial*)malloc(TotalMat * sizeof(GMaterial));
-#endif
 	memset(Material,0,TotalMat * sizeof(GMaterial));
 	for (int index = 0; index < TotalMat; index++) calc_material(index);
+#else
+	// init_shared() hands over zeroed pages, entries are filled on first probe (see FlagMaterialValid)
+#endif
 }
 
 void init_hash() {
 #ifdef TUNER
 	return;
 #endif
+#ifdef POSIX_BUILD
+	if (child) return; // fork() hands the parent's mapping down
+	sint64 size = (hash_size * sizeof(GEntry));
+	if (HashSize) munmap(Hash, HashSize);
+	Hash = (GEntry*)MAP_FAILED;
+#if defined(LARGE_PAGES) && defined(MAP_HUGETLB)
+	if (LargePages) {
+		Hash = (GEntry*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (Hash != (GEntry*)MAP_FAILED) fprintf(stdout, "Large page hash\n");
+	}
+#endif
+	if (Hash == (GEntry*)MAP_FAILED) {
+		Hash = (GEntry*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (Hash == (GEntry*)MAP_FAILED) {
+			fprintf(stdout, "Hash allocation failed: %s\n", strerror(errno));
+			exit(1);
+		}
+#if defined(LARGE_PAGES) && defined(MADV_HUGEPAGE)
+		if (LargePages) madvise(Hash, size, MADV_HUGEPAGE);
+#endif
+	}
+	HashSize = size; // anonymous mappings come zeroed
+	hash_mask = hash_size - 4;
+#else
 	char name[256];
 	sint64 size = (hash_size * sizeof(GEntry));
 	sprintf(name, "GULL_HASH_%d", WinParId);
@@ -2666,12 +2771,23 @@ hash_allocated:
 	Hash = (GEntry*)MapViewOfFile(HASH, FILE_MAP_ALL_ACCESS, 0, 0, size);
 	if (parent) memset(Hash, 0, size);
 	hash_mask = hash_size - 4;
+#endif
 }
 
 void init_shared() {
 #ifdef TUNER
 	return;
 #endif
+#ifdef POSIX_BUILD
+	sint64 size = SharedPVHashOffset + pv_hash_size * sizeof(GPVEntry);
+	if (SharedSize) munmap(Smpi, SharedSize);
+	Smpi = (GSMPI*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (Smpi == (GSMPI*)MAP_FAILED) {
+		fprintf(stdout, "Shared memory allocation failed: %s\n", strerror(errno));
+		exit(1);
+	}
+	SharedSize = size; // zeroed, fork()ed children share it
+#else
 	char name[256];
 	sint64 size = SharedPVHashOffset + pv_hash_size * sizeof(GPVEntry);
 	sprintf(name, "GULL_SHARED_%d", WinParId);
@@ -2683,6 +2799,7 @@ void init_shared() {
 	else SHARED = OpenFileMapping(FILE_MAP_ALL_ACCESS, 0, name);
 	Smpi = (GSMPI*)MapViewOfFile(SHARED, FILE_MAP_ALL_ACCESS, 0, 0, size);
 	if (parent) memset(Smpi, 0, size);
+#endif
 	Material = (GMaterial*)(((char*)Smpi) + SharedMaterialOffset);
 	MagicAttacks = (uint64*)(((char*)Smpi) + SharedMagicOffset);
 	PVHash = (GPVEntry*)(((char*)Smpi) + SharedPVHashOffset);
@@ -3958,6 +4075,8 @@ template <bool HPopCnt> void evaluation() {
 	EI.material = &Material[Current->material];
 #ifdef TUNER
 	if (EI.material->generation != generation) calc_material(Current->material);
+#else
+	if (F(EI.material->flags & FlagMaterialValid)) calc_material(Current->material);
 #endif
 	Current->score = EI.material->score + (((Opening(EI.score) * EI.material->phase) + (Endgame(EI.score) * (128 - (int)EI.material->phase)))/128);
 
@@ -6201,9 +6320,9 @@ void send_pv(int depth, int alpha, int beta, int score) {
 #endif
 	if (nps) nps = (snodes * 1000)/nps; 
 	if (score < beta) {
-		if (score <= alpha) fprintf(stdout,"info depth %d seldepth %d score %s%d upperbound nodes %I64d nps %I64d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
-		else fprintf(stdout,"info depth %d seldepth %d score %s%d nodes %I64d nps %I64d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
-	} else fprintf(stdout,"info depth %d seldepth %d score %s%d lowerbound nodes %I64d nps %I64d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
+		if (score <= alpha) fprintf(stdout,"info depth %d seldepth %d score %s%d upperbound nodes %" I64 "d nps %" I64 "d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
+		else fprintf(stdout,"info depth %d seldepth %d score %s%d nodes %" I64 "d nps %" I64 "d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
+	} else fprintf(stdout,"info depth %d seldepth %d score %s%d lowerbound nodes %" I64 "d nps %" I64 "d pv %s\n",depth,sel_depth,score_string,(mate ? mate_score : score),snodes,nps,pv_string);
 	fflush(stdout);
 }
 
@@ -6266,7 +6385,7 @@ void send_multipv(int depth, int curr_number) {
 		snodes = nodes;
 #endif
 	    if (nps) nps = (snodes * 1000)/nps; 
-		fprintf(stdout,"info multipv %d depth %d score %s%d nodes %I64d nps %I64d pv %s\n",j + 1,(j <= curr_number ? depth : depth - 1),score_string,score,snodes,nps,pv_string);
+		fprintf(stdout,"info multipv %d depth %d score %s%d nodes %" I64 "d nps %" I64 "d pv %s\n",j + 1,(j <= curr_number ? depth : depth - 1),score_string,score,snodes,nps,pv_string);
 		fflush(stdout);
 	}
 }
@@ -6284,7 +6403,7 @@ void send_best_move() {
 #else
 	snodes = nodes;
 #endif
-	fprintf(stdout,"info nodes %I64d score cp %d\n",snodes,best_score);
+	fprintf(stdout,"info nodes %" I64 "d score cp %d\n",snodes,best_score);
 	if (!best_move) return;
 	Current = Data;
 	evaluate();
@@ -6447,7 +6566,12 @@ void get_time_limit(char string[]) {
 	}
     InfoTime = StartTime = get_time();
 	Searching = 1;
-	if (MaxPrN > 1) SET_BIT_64(Smpi->searching, 0);
+	if (MaxPrN > 1) {
+		SET_BIT_64(Smpi->searching, 0);
+#ifdef POSIX_BUILD
+		idle_wake(&Smpi->searching);
+#endif
+	}
 	if (F(Infinite)) PVN = 1;
 	if (Current->turn == White) root<0>(); else root<1>();
 }
@@ -6467,8 +6591,32 @@ sint64 get_time() {
 	}
 #endif
 #endif
+#ifndef POSIX_BUILD
 	return GetTickCount();
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (sint64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+#ifdef POSIX_BUILD
+// idle children sleep on the low word of Smpi->searching; the mapping is shared between processes, so no FUTEX_PRIVATE_FLAG
+void idle_wait(volatile long long * word) {
+#ifdef __linux__
+	timespec timeout = { 0, 100000000 };
+	syscall(SYS_futex, (int*)word, FUTEX_WAIT, (int)(*word), &timeout, NULL, 0);
+#else
+	usleep(1000);
+#endif
+}
+
+void idle_wake(volatile long long * word) {
+#ifdef __linux__
+	syscall(SYS_futex, (int*)word, FUTEX_WAKE, 0x7FFFFFFF, NULL, NULL, 0);
+#endif
 }
+#endif
 
 int time_to_stop(GSearchInfo * SI, int time, int searching) {
 	if (Infinite) return 0;
@@ -6499,9 +6647,10 @@ void check_time(int searching) {
 #else
 	while (!Stop && input()) uci();
 #endif
+	int Time;
 	if (Stop) goto jump;
 	CurrTime = get_time();
-	int Time = Convert(CurrTime - StartTime,int);
+	Time = Convert(CurrTime - StartTime,int);
 	if (T(Print) && Time > InfoLag && CurrTime - InfoTime > InfoDelay) {
 		InfoTime = CurrTime;
 		if (info_string[0]) {
@@ -6525,9 +6674,10 @@ void check_time(int time, int searching) {
 #else
 	while (!Stop && input()) uci();
 #endif
+	int Time;
 	if (Stop) goto jump;
 	CurrTime = get_time();
-	int Time = Convert(CurrTime - StartTime,int);
+	Time = Convert(CurrTime - StartTime,int);
 	if (T(Print) && Time > InfoLag && CurrTime - InfoTime > InfoDelay) {
 		InfoTime = CurrTime;
 		if (info_string[0]) {
@@ -6565,7 +6715,11 @@ start:
 	if (TEST_RESET_BIT(Smpi->stop, Id)) longjmp(CheckJump, 1);
 	if (Smpi->searching & Bit(Id)) return;
 	if (!(Smpi->searching & 1)) {
+#ifndef POSIX_BUILD
 		Sleep(1);
+#else
+		idle_wait(&Smpi->searching);
+#endif
 		return;
 	}
 	while ((Smpi->searching & 1) && !Smpi->active_sp) _mm_pause();
@@ -6660,12 +6814,17 @@ start:
 
 int input() {
 	if (child) return 0;
-    DWORD p;
 	if (F(Input)) return 0;
+#ifdef POSIX_BUILD
+	pollfd fd = { 0, POLLIN, 0 };
+	return poll(&fd, 1, 0) > 0;
+#else
+    DWORD p;
 	if (F(Console)) {
 	    if (PeekNamedPipe(StreamHandle,NULL,0,NULL,&p,NULL)) return (p > 0);
         else return 1;
 	} else return 0;
+#endif
 }
 
 void epd_test(char string[], int time_limit) {
@@ -6878,8 +7037,13 @@ void uci() {
 		if (F(Searching)) send_best_move();
 	} else if (!strcmp(mstring, "quit")) {
 		for (i = 1; i < PrN; i++) {
+#ifndef POSIX_BUILD
 			TerminateProcess(ChildPr[i], 0);
 			CloseHandle(ChildPr[i]);
+#else
+			kill(ChildPr[i], SIGKILL);
+			waitpid(ChildPr[i], NULL, 0);
+#endif
 		}
 		exit(0);
 	} else if (!memcmp(mstring, "epd", 3)) {
@@ -6889,6 +7053,23 @@ void uci() {
 	}
 }
 
+#ifdef POSIX_BUILD
+pid_t CreateChildProcess(int child_id) {
+	fflush(NULL);
+	pid_t pid = fork();
+	if (pid == 0) {
+		child = 1; parent = 0;
+		Id = child_id;
+#ifdef __linux__
+		prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+		if (getppid() != WinParId) _exit(0);
+		while (true) check_state();
+	}
+	if (pid < 0) fprintf(stdout, "Error %d\n", errno);
+	return pid;
+}
+#else
 HANDLE CreateChildProcess(int child_id) {
 	char name[1024];
 	TCHAR szCmdline[1024];
@@ -6917,10 +7098,25 @@ HANDLE CreateChildProcess(int child_id) {
 		return NULL;
 	}
 }
+#endif
 
-void main(int argc, char *argv[]) {
-	DWORD p;
+int main(int argc, char *argv[]) {
 	int i, HT = 0;
+#ifdef POSIX_BUILD
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	HardwarePopCnt = __get_cpuid(1, &eax, &ebx, &ecx, &edx) ? (ecx >> 23) & 1 : 0;
+	(void)argc; (void)argv; (void)HT; // Windows only: child command line, HT detection
+
+	if (parent) {
+		WinParId = getpid();
+		if (MaxPrN > 1) {
+			CPUs = Max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+			PrN = Min(CPUs, MaxPrN);
+		}
+	}
+	Console = 0;
+#else
+	DWORD p;
 	SYSTEM_INFO sysinfo;
 
 	if (argc >= 2) if (!memcmp(argv[1], "child", 5)) {
@@ -6958,16 +7154,19 @@ void main(int argc, char *argv[]) {
 
 #ifdef CPU_TIMING
 	SetPriorityClass(GetCurrentProcess(), IDLE_PRIORITY_CLASS);
+#endif
 #endif
 
 	init();
 
+#ifndef POSIX_BUILD
 	StreamHandle = GetStdHandle(STD_INPUT_HANDLE);
 	Console = GetConsoleMode(StreamHandle, &p);
 	if (Console) {
 		SetConsoleMode(StreamHandle, p & (~(ENABLE_MOUSE_INPUT | ENABLE_WINDOW_INPUT)));
 		FlushConsoleInputBuffer(StreamHandle);
 	}
+#endif
 
 	setbuf(stdout, NULL);
 	setbuf(stdin, NULL);
@@ -6985,11 +7184,16 @@ reset_jump:
 #ifndef TUNER
 	if (parent) {
 		if (setjmp(ResetJump)) {
+#ifndef POSIX_BUILD
 			for (i = 1; i < PrN; i++) TerminateProcess(ChildPr[i], 0);
 			for (i = 1; i < PrN; i++) {
 				WaitForSingleObject(ChildPr[i], INFINITE);
 				CloseHandle(ChildPr[i]);
 			}
+#else
+			for (i = 1; i < PrN; i++) kill(ChildPr[i], SIGKILL);
+			for (i = 1; i < PrN; i++) waitpid(ChildPr[i], NULL, 0);
+#endif
 			Smpi->searching = Smpi->active_sp = Smpi->stop = 0;
 			for (i = 0; i < MaxSplitPoints; i++) Smpi->Sp->active = Smpi->Sp->claimed = 0;
 				
@@ -78,6 +78,8 @@ struct board_t {
    uint64 pawn_key;
    uint64 material_key;
 
+   int thread; // owner of the per-thread pawn and material tables, for prefetching
+
    uint64 stack[StackSize];
 };
 
@@ -15,6 +15,7 @@
 #include "piece.h"
 #include "protocol.h"
 #include "random.h"
+#include "search.h"
 #include "square.h"
 #include "trans.h"
 #include "util.h"
@@ -54,6 +55,8 @@ int main(int argc, char * argv[]) {
    
    book_init();
 
+   search_alloc(); // thread 0, the others once "Number of Threads" is known
+
    // loop
 
    loop();
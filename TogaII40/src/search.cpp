@@ -77,10 +77,12 @@ int NumberThreads = 1;
 //CRITICAL_SECTION CriticalSection; 
 
 search_input_t SearchInput[1];
-search_info_t SearchInfo[MaxThreads][1];
-search_root_t SearchRoot[MaxThreads][1];
-search_current_t SearchCurrent[MaxThreads][1];
-search_best_t SearchBest[MaxThreads][MultiPVMax];
+search_info_t * SearchInfo[MaxThreads];
+search_root_t * SearchRoot[MaxThreads];
+search_current_t * SearchCurrent[MaxThreads];
+search_best_t * SearchBest[MaxThreads];
+
+static search_thread_t * SearchThread[MaxThreads]; // NULL above NumberThreads
 
 // prototypes
 
@@ -107,6 +109,43 @@ bool height_is_ok(int height) {
    return height >= 0 && height < HeightMax;
 }
 
+// search_alloc()
+
+void search_alloc() {
+
+   int ThreadId;
+   search_thread_t * thread;
+
+   // state for the configured threads only, thread 0 always exists
+
+   for (ThreadId = 0; ThreadId < MaxThreads; ThreadId++) {
+
+      thread = SearchThread[ThreadId];
+
+      if (ThreadId < NumberThreads && thread == NULL) {
+
+         thread = (search_thread_t *) my_malloc(sizeof(search_thread_t));
+         memset(thread,0,sizeof(search_thread_t));
+
+         SearchThread[ThreadId] = thread;
+         SearchInfo[ThreadId] = thread->info;
+         SearchCurrent[ThreadId] = thread->current;
+         SearchRoot[ThreadId] = thread->root;
+         SearchBest[ThreadId] = thread->best;
+
+      } else if (ThreadId >= NumberThreads && ThreadId > 0 && thread != NULL) {
+
+         my_free(thread);
+
+         SearchThread[ThreadId] = NULL;
+         SearchInfo[ThreadId] = NULL;
+         SearchCurrent[ThreadId] = NULL;
+         SearchRoot[ThreadId] = NULL;
+         SearchBest[ThreadId] = NULL;
+      }
+   }
+}
+
 // search_clear()
 
 void search_clear() {
@@ -158,6 +197,7 @@ void search_clear() {
 
 		SearchCurrent[ThreadId]->max_depth = 0;
 		SearchCurrent[ThreadId]->node_nb = 0;
+		SearchCurrent[ThreadId]->defer_nb = 0;
 		SearchCurrent[ThreadId]->time = 0.0;
 		SearchCurrent[ThreadId]->speed = 0.0;
 		SearchCurrent[ThreadId]->cpu = 0.0;
@@ -270,12 +310,12 @@ void search() {
 
          // play book move
 
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].move = move;
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].value = 1;
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].flags = SearchExact;
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].depth = 1;
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].pv[0] = move;
-         SearchBest[0][SearchCurrent[ThreadId]->multipv].pv[1] = MoveNone;
+         SearchBest[0][SearchCurrent[0]->multipv].move = move;
+         SearchBest[0][SearchCurrent[0]->multipv].value = 1;
+         SearchBest[0][SearchCurrent[0]->multipv].flags = SearchExact;
+         SearchBest[0][SearchCurrent[0]->multipv].depth = 1;
+         SearchBest[0][SearchCurrent[0]->multipv].pv[0] = move;
+         SearchBest[0][SearchCurrent[0]->multipv].pv[1] = MoveNone;
 
          search_update_best(0);
 
@@ -298,6 +338,8 @@ void search() {
 
    trans_inc_date(Trans);
 
+   search_full_clear();
+
    // resume threads
 
    resume_threads();
@@ -377,6 +419,7 @@ void search_smp(int ThreadId) {
    // SearchCurrent
 
    board_copy(SearchCurrent[ThreadId]->board,SearchInput->board);
+   SearchCurrent[ThreadId]->board->thread = ThreadId;
    my_timer_reset(SearchCurrent[ThreadId]->timer);
    my_timer_start(SearchCurrent[ThreadId]->timer);
 
@@ -413,6 +456,7 @@ void search_smp(int ThreadId) {
 			  SearchRoot[ThreadId]->change = false;
 
 			  board_copy(SearchCurrent[ThreadId]->board,SearchInput->board);
+			  SearchCurrent[ThreadId]->board->thread = ThreadId;
 			  
 			  // Aspiration windows (JD)
 			  
@@ -13,18 +13,29 @@
 #include "move_gen.h"
 #include "move_legal.h"
 #include "piece.h"
+#include "protocol.h"
 #include "search.h"
 #include "see.h"
 #include "sort.h"
 #include "util.h"
 #include "value.h"
 
+#if STATS
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  elif defined(__i386__) || defined(__x86_64__)
+#    include <x86intrin.h>
+#  endif
+#endif
+
 // constants
 
 static const int KillerNb = 2;
 
 static const int HistorySize = 12 * 64 /** 64*/;
-static const int HistoryMax = 2048;
+static const int ReplySize = 6 * 64; // piece type and "to", the colour follows from the path
+static const int HistoryMax = 2048; // score bound of each history table
+static const int HistoryHitMax = 2048; // hist_tot bound, hit and tot are halved together
 
 static const int TransScore   = +32766;
 static const int GoodScore    =  +4000;
@@ -36,10 +47,45 @@ static const int CODE_SIZE = 256;
 
 // macros
 
+#define ABS(x) ((x)<0?-(x):(x))
+#define MIN(a,b) ((a)<=(b)?(a):(b))
+
 #define HISTORY_INC(depth) ((depth)*(depth))
 
+#if STATS
+#  if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+#    define TICKS() (uint64(__rdtsc()))
+#  else
+#    define TICKS() (uint64(0))
+#  endif
+#endif
+
 // types
 
+// all counters of one history index share a cache line
+
+struct history_t {
+   sint16 score; // quiet move ordering, within +/-HistoryMax
+   uint16 hit; // fail-high rate for history_prob()
+   uint16 tot;
+};
+
+// per-thread move ordering tables, the small hot ones first
+
+struct sort_table_t {
+   uint16 killer[HeightMax][KillerNb];
+   sint16 path[HeightMax]; // history index of the move into each height, -1 if none
+   history_t history[HistorySize];
+#if STATS
+   uint64 update_nb; // history maintenance, see sort_stats()
+   uint64 update_ticks;
+   uint64 start_ticks;
+#endif
+   uint16 refutation[12][64][64];
+   sint16 counter[HistorySize][ReplySize]; // [previous move][move]
+   sint16 follow[HistorySize][ReplySize]; // [own move two plies ago][move]
+};
+
 enum gen_t {
    GEN_ERROR,
    GEN_LEGAL_EVASION,
@@ -78,23 +124,18 @@ static int PosCaptureQS;
 
 static int Code[CODE_SIZE];
 
-static uint16 Killer[MaxThreads][HeightMax][KillerNb];
-static uint16 Refutation[MaxThreads][12][64][64];
-
-static sint16 History[MaxThreads][HistorySize];
-static uint16 HistHit[MaxThreads][HistorySize];
-static uint16 HistTot[MaxThreads][HistorySize];
+static sort_table_t * SortTable[MaxThreads]; // NULL above NumberThreads
 
 // prototypes
 
 static void note_captures     (list_t * list, const board_t * board);
-static void note_quiet_moves  (list_t * list, const board_t * board, int ThreadId);
+static void note_quiet_moves  (list_t * list, const board_t * board, int height, int ThreadId);
 static void note_moves_simple (list_t * list, const board_t * board);
 static void note_mvv_lva      (list_t * list, const board_t * board);
 
 static int  move_value        (int move, const board_t * board, int height, int trans_killer, int ThreadId);
 static int  capture_value     (int move, const board_t * board);
-static int  quiet_move_value  (int move, const board_t * board, int ThreadId);
+static int  quiet_move_value  (int move, const board_t * board, int height, int ThreadId);
 static int  move_value_simple (int move, const board_t * board);
 
 static int  history_prob      (int move, const board_t * board, int ThreadId);
@@ -104,9 +145,32 @@ static bool capture_is_good   (int move, const board_t * board);
 static int  mvv_lva           (int move, const board_t * board);
 
 static uint16  history_index  (int move, const board_t * board);
+static uint16  reply_index    (int move, const board_t * board);
+static void    history_update (sint16 * score, int bonus);
+static void    history_scores (int move, const board_t * board, int height, int bonus, int ThreadId);
 
 // functions
 
+// sort_alloc()
+
+void sort_alloc() {
+
+   int ThreadId;
+
+   // tables for the configured threads only
+
+   for (ThreadId = 0; ThreadId < MaxThreads; ThreadId++) {
+
+      if (ThreadId < NumberThreads && SortTable[ThreadId] == NULL) {
+         SortTable[ThreadId] = (sort_table_t *) my_malloc(sizeof(sort_table_t));
+         sort_init(ThreadId);
+      } else if (ThreadId >= NumberThreads && SortTable[ThreadId] != NULL) {
+         my_free(SortTable[ThreadId]);
+         SortTable[ThreadId] = NULL;
+      }
+   }
+}
+
 // sort_init()
 
 void sort_init(int ThreadId) {
@@ -118,28 +182,39 @@ void sort_init(int ThreadId) {
    // killer
 
    for (height = 0; height < HeightMax; height++) {
-      for (i = 0; i < KillerNb; i++) Killer[ThreadId][height][i] = MoveNone;
+      for (i = 0; i < KillerNb; i++) SortTable[ThreadId]->killer[height][i] = MoveNone;
    }
    
    // refutation table
    
    for (i = 0; i < 12; i++) {
       for (j = 0; j < 64; j++){
-      	for (k = 0; k < 64; k++)Refutation[ThreadId][i][j][k] = MoveNone;
+      	for (k = 0; k < 64; k++)SortTable[ThreadId]->refutation[i][j][k] = MoveNone;
       } 
    }
 
    // history
 
-   for (i = 0; i < HistorySize; i++) History[ThreadId][i] = 0;
+   for (i = 0; i < HistorySize; i++) {
+      SortTable[ThreadId]->history[i].score = 0;
+      SortTable[ThreadId]->history[i].hit = 1;
+      SortTable[ThreadId]->history[i].tot = 1;
+   }
+
+   for (i = 0; i < HistorySize; i++) {
+      for (j = 0; j < ReplySize; j++) {
+         SortTable[ThreadId]->counter[i][j] = 0;
+         SortTable[ThreadId]->follow[i][j] = 0;
+      }
+   }
+
+   for (height = 0; height < HeightMax; height++) SortTable[ThreadId]->path[height] = -1;
 
-   //if (first_time){
-	   for (i = 0; i < HistorySize; i++) {
-		  HistHit[ThreadId][i] = 1;
-		  HistTot[ThreadId][i] = 1;
-	   }
-	//   first_time = false;
-   //}
+#if STATS
+   SortTable[ThreadId]->update_nb = 0;
+   SortTable[ThreadId]->update_ticks = 0;
+   SortTable[ThreadId]->start_ticks = TICKS();
+#endif
 
    // Code[]
 
@@ -209,9 +284,14 @@ void sort_init(sort_t * sort, board_t * board, const attack_t * attack, int dept
    sort->capture_nb = 0;
 
    sort->trans_killer = trans_killer;
-   sort->killer_1 = Killer[ThreadId][sort->height][0];
-   sort->killer_2 = Killer[ThreadId][sort->height][1];
-   sort->refutation_move = Refutation[ThreadId][piece][from_64][to_64];
+   sort->killer_1 = SortTable[ThreadId]->killer[sort->height][0];
+   sort->killer_2 = SortTable[ThreadId]->killer[sort->height][1];
+   sort->refutation_move = MoveNone;
+   SortTable[ThreadId]->path[height] = -1;
+   if (piece >= 0) { // last_move can be stale (empty "to" square), the table has no slack around it
+      sort->refutation_move = SortTable[ThreadId]->refutation[piece][from_64][to_64];
+      if (last_move != MoveNone && last_move != MoveNull) SortTable[ThreadId]->path[height] = piece * 64 + to_64;
+   }
    
    if (ATTACK_IN_CHECK(sort->attack)) {
 
@@ -364,7 +444,7 @@ int sort_next(sort_t * sort, int ThreadId) {
       } else if (gen == GEN_QUIET) {
 
          gen_quiet_moves(sort->list,sort->board);
-         note_quiet_moves(sort->list,sort->board,ThreadId);
+         note_quiet_moves(sort->list,sort->board,sort->height,ThreadId);
          list_sort(sort->list);
 
          sort->test = TEST_QUIET;
@@ -502,8 +582,9 @@ int sort_next_qs(sort_t * sort) {
 
 void good_move(int move, const board_t * board, int depth, int height, int ThreadId) {
 
-   uint16 index;
-   int i;
+#if STATS
+   uint64 start;
+#endif
 
    ASSERT(move_is_ok(move));
    ASSERT(board!=NULL);
@@ -515,33 +596,34 @@ void good_move(int move, const board_t * board, int depth, int height, int Threa
 
    // killer
 
-   if (Killer[ThreadId][height][0] != move) {
-      Killer[ThreadId][height][1] = Killer[ThreadId][height][0];
-      Killer[ThreadId][height][0] = move;
+   if (SortTable[ThreadId]->killer[height][0] != move) {
+      SortTable[ThreadId]->killer[height][1] = SortTable[ThreadId]->killer[height][0];
+      SortTable[ThreadId]->killer[height][0] = move;
    }
 
-   ASSERT(Killer[ThreadId][height][0]==move);
-   ASSERT(Killer[ThreadId][height][1]!=move);
+   ASSERT(SortTable[ThreadId]->killer[height][0]==move);
+   ASSERT(SortTable[ThreadId]->killer[height][1]!=move);
    
    // history
 
-   index = history_index(move,board);
+#if STATS
+   start = TICKS();
+#endif
 
-   History[ThreadId][index] += HISTORY_INC(depth);
+   history_scores(move,board,height,MIN(HISTORY_INC(depth),HistoryMax),ThreadId);
 
-   if (History[ThreadId][index] >= HistoryMax) {
-      for (i = 0; i < HistorySize; i++) {
-         History[ThreadId][i] = (History[ThreadId][i] + 1) / 2;
-      }
-   } 
+#if STATS
+   SortTable[ThreadId]->update_ticks += TICKS() - start;
+#endif
 }
 
 // bad_move()
 
 void bad_move(int move, const board_t * board, int depth, int height, int ThreadId) {
 
-   uint16 index;
-   int i;
+#if STATS
+   uint64 start;
+#endif
 
    ASSERT(move_is_ok(move));
    ASSERT(board!=NULL);
@@ -552,15 +634,15 @@ void bad_move(int move, const board_t * board, int depth, int height, int Thread
 
    // history
 
-   index = history_index(move,board);
+#if STATS
+   start = TICKS();
+#endif
 
-   History[ThreadId][index] -= depth;
+   history_scores(move,board,height,-MIN(depth,HistoryMax),ThreadId);
 
-   if (History[ThreadId][index] >= HistoryMax) {
-      for (i = 0; i < HistorySize; i++) {
-         History[ThreadId][i] = (History[ThreadId][i] + 1) / 2;
-      }
-   } 
+#if STATS
+   SortTable[ThreadId]->update_ticks += TICKS() - start;
+#endif
 }
 
 // refutation_update()
@@ -583,9 +665,11 @@ void refutation_update(int best_move, int last_move, const board_t * board, int
 
    //if (move_is_tactical(move,board)) return;
 
+   if (piece < 0) return; // stale last_move, see sort_init()
+
    // refutation
 
-   Refutation[ThreadId][piece][from_64][to_64] = best_move;
+   SortTable[ThreadId]->refutation[piece][from_64][to_64] = best_move;
    
 }
    
@@ -595,6 +679,10 @@ void refutation_update(int best_move, int last_move, const board_t * board, int
 void history_good(int move, const board_t * board, int ThreadId) {
 
    uint16 index;
+   history_t * entry;
+#if STATS
+   uint64 start;
+#endif
 
    ASSERT(move_is_ok(move));
    ASSERT(board!=NULL);
@@ -603,18 +691,28 @@ void history_good(int move, const board_t * board, int ThreadId) {
 
    // history
 
+#if STATS
+   start = TICKS();
+#endif
+
    index = history_index(move,board);
+   entry = &SortTable[ThreadId]->history[index];
 
-   HistHit[ThreadId][index]++;
-   HistTot[ThreadId][index]++;
-   
-   if (HistTot[ThreadId][index] >= HistoryMax) {
-      HistHit[ThreadId][index] = (HistHit[ThreadId][index] + 1) / 2;
-      HistTot[ThreadId][index] = (HistTot[ThreadId][index] + 1) / 2;
+   entry->hit++;
+   entry->tot++;
+
+   if (entry->tot >= HistoryHitMax) { // this entry only
+      entry->hit = (entry->hit + 1) / 2;
+      entry->tot = (entry->tot + 1) / 2;
    }
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+#if STATS
+   SortTable[ThreadId]->update_nb++;
+   SortTable[ThreadId]->update_ticks += TICKS() - start;
+#endif
+
+   ASSERT(entry->hit<=entry->tot);
+   ASSERT(entry->tot<HistoryHitMax);
 }
 
 // history_bad()
@@ -622,6 +720,10 @@ void history_good(int move, const board_t * board, int ThreadId) {
 void history_bad(int move, const board_t * board, int ThreadId) {
 
    uint16 index;
+   history_t * entry;
+#if STATS
+   uint64 start;
+#endif
 
    ASSERT(move_is_ok(move));
    ASSERT(board!=NULL);
@@ -630,17 +732,27 @@ void history_bad(int move, const board_t * board, int ThreadId) {
 
    // history
 
+#if STATS
+   start = TICKS();
+#endif
+
    index = history_index(move,board);
+   entry = &SortTable[ThreadId]->history[index];
 
-   HistTot[ThreadId][index]++;
-   
-   if (HistTot[ThreadId][index] >= HistoryMax) {
-      HistHit[ThreadId][index] = (HistHit[ThreadId][index] + 1) / 2;
-      HistTot[ThreadId][index] = (HistTot[ThreadId][index] + 1) / 2;
+   entry->tot++;
+
+   if (entry->tot >= HistoryHitMax) { // this entry only
+      entry->hit = (entry->hit + 1) / 2;
+      entry->tot = (entry->tot + 1) / 2;
    }
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+#if STATS
+   SortTable[ThreadId]->update_nb++;
+   SortTable[ThreadId]->update_ticks += TICKS() - start;
+#endif
+
+   ASSERT(entry->hit<=entry->tot);
+   ASSERT(entry->tot<HistoryHitMax);
 }
 
 void history_reset(int move, const board_t * board, int ThreadId) {
@@ -654,13 +766,39 @@ void history_reset(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   HistHit[ThreadId][index] = 1; //HistHit[ThreadId][index]/3 + 1;
-   HistTot[ThreadId][index] = 1; //HistHit[ThreadId][index]/2 + 1;
+   SortTable[ThreadId]->history[index].hit = 1; //SortTable[ThreadId]->history[index].hit/3 + 1;
+   SortTable[ThreadId]->history[index].tot = 1; //SortTable[ThreadId]->history[index].hit/2 + 1;
+}
+
+// sort_stats()
+
+#if STATS
+
+void sort_stats() {
+
+   int ThreadId;
+   uint64 update_nb, update_ticks, total_ticks;
+
+   // history maintenance over all threads, in TSC ticks (0 where there is no TSC)
+
+   update_nb = 0;
+   update_ticks = 0;
+   total_ticks = 0;
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+      update_nb += SortTable[ThreadId]->update_nb;
+      update_ticks += SortTable[ThreadId]->update_ticks;
+      total_ticks += TICKS() - SortTable[ThreadId]->start_ticks;
+   }
+
+   send("info string history " S64_FORMAT " updates %.1f ticks/update %.2f%% of search",
+        sint64(update_nb),
+        (update_nb == 0) ? 0.0 : double(update_ticks) / double(update_nb),
+        (total_ticks == 0) ? 0.0 : double(update_ticks) * 100.0 / double(total_ticks));
 }
 
+#endif
+
 // note_moves()
 
 void note_moves(list_t * list, const board_t * board, int height, int trans_killer, int ThreadId) {
@@ -705,7 +843,7 @@ static void note_captures(list_t * list, const board_t * board) {
 
 // note_quiet_moves()
 
-static void note_quiet_moves(list_t * list, const board_t * board, int ThreadId) {
+static void note_quiet_moves(list_t * list, const board_t * board, int height, int ThreadId) {
 
    int size;
    int i, move;
@@ -718,7 +856,7 @@ static void note_quiet_moves(list_t * list, const board_t * board, int ThreadId)
    if (size >= 2) {
       for (i = 0; i < size; i++) {
          move = LIST_MOVE(list,i);
-         list->value[i] = quiet_move_value(move,board,ThreadId);
+         list->value[i] = quiet_move_value(move,board,height,ThreadId);
       }
    }
 }
@@ -779,12 +917,12 @@ static int move_value(int move, const board_t * board, int height, int trans_kil
       value = TransScore;
    } else if (move_is_tactical(move,board)) { // capture or promote
       value = capture_value(move,board);
-   } else if (move == Killer[ThreadId][height][0]) { // killer 1
+   } else if (move == SortTable[ThreadId]->killer[height][0]) { // killer 1
       value = KillerScore;
-   } else if (move == Killer[ThreadId][height][1]) { // killer 2
+   } else if (move == SortTable[ThreadId]->killer[height][1]) { // killer 2
       value = KillerScore - 2;
    } else { // quiet move
-      value = quiet_move_value(move,board,ThreadId);
+      value = quiet_move_value(move,board,height,ThreadId);
    }
 
    return value;
@@ -816,20 +954,36 @@ static int capture_value(int move, const board_t * board) {
 
 // quiet_move_value()
 
-static int quiet_move_value(int move, const board_t * board, int ThreadId) {
+static int quiet_move_value(int move, const board_t * board, int height, int ThreadId) {
 
    int value;
-   uint16 index;
+   uint16 index, reply;
+   int path;
 
    ASSERT(move_is_ok(move));
    ASSERT(board!=NULL);
+   ASSERT(height_is_ok(height));
 
    ASSERT(!move_is_tactical(move,board));
 
    index = history_index(move,board);
 
-   value = HistoryScore + History[ThreadId][index];
-   ASSERT(value>=HistoryScore&&value<=KillerScore-4);
+   value = HistoryScore + SortTable[ThreadId]->history[index].score;
+
+   // countermove and follow-up history
+
+   reply = reply_index(move,board);
+
+   if (height >= 1 && (path=SortTable[ThreadId]->path[height]) >= 0) {
+      value += SortTable[ThreadId]->counter[path][reply];
+   }
+
+   if (height >= 2 && (path=SortTable[ThreadId]->path[height-1]) >= 0) {
+      value += SortTable[ThreadId]->follow[path][reply];
+   }
+
+   ASSERT(value>=HistoryScore-3*HistoryMax&&value<=HistoryScore+3*HistoryMax);
+   ASSERT(value>BadScore&&value<=KillerScore-4);
 
    return value;
 }
@@ -863,10 +1017,10 @@ static int history_prob(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   ASSERT(SortTable[ThreadId]->history[index].hit<=SortTable[ThreadId]->history[index].tot);
+   ASSERT(SortTable[ThreadId]->history[index].tot<HistoryHitMax);
 
-   value = (HistHit[ThreadId][index] * 16384) / HistTot[ThreadId][index];
+   value = (SortTable[ThreadId]->history[index].hit * 16384) / SortTable[ThreadId]->history[index].tot;
    
    ASSERT(value>=0&&value<=16384);
 
@@ -965,5 +1119,71 @@ static uint16 history_index(int move, const board_t * board) {
    return index;
 }
 
+// reply_index()
+
+static uint16 reply_index(int move, const board_t * board) {
+
+   uint16 index;
+
+   ASSERT(move_is_ok(move));
+   ASSERT(board!=NULL);
+
+   ASSERT(!move_is_tactical(move,board));
+
+   index = PIECE_ORDER(board->square[MOVE_FROM(move)]) * 64 + SQUARE_TO_64(MOVE_TO(move));
+
+   ASSERT(index>=0&&index<ReplySize);
+
+   return index;
+}
+
+// history_update()
+
+static void history_update(sint16 * score, int bonus) {
+
+   ASSERT(score!=NULL);
+   ASSERT(bonus>=-HistoryMax&&bonus<=+HistoryMax);
+
+   // gravity: the step shrinks as the score nears the bound, so no table ever needs rescaling
+
+   *score += bonus - *score * ABS(bonus) / HistoryMax;
+
+   ASSERT(*score>=-HistoryMax&&*score<=+HistoryMax);
+}
+
+// history_scores()
+
+static void history_scores(int move, const board_t * board, int height, int bonus, int ThreadId) {
+
+   uint16 index, reply;
+   int path;
+
+   ASSERT(move_is_ok(move));
+   ASSERT(board!=NULL);
+   ASSERT(height_is_ok(height));
+
+   index = history_index(move,board);
+   reply = reply_index(move,board);
+
+   history_update(&SortTable[ThreadId]->history[index].score,bonus);
+#if STATS
+   SortTable[ThreadId]->update_nb++;
+#endif
+
+   if (height >= 1 && (path=SortTable[ThreadId]->path[height]) >= 0) {
+      history_update(&SortTable[ThreadId]->counter[path][reply],bonus);
+#if STATS
+      SortTable[ThreadId]->update_nb++;
+#endif
+   }
+
+   if (height >= 2 && (path=SortTable[ThreadId]->path[height-1]) >= 0) {
+      history_update(&SortTable[ThreadId]->follow[path][reply],bonus);
+#if STATS
+      SortTable[ThreadId]->update_nb++;
+#endif
+   }
+}
+
 // end of sort.cpp
 
@@ -34,6 +34,7 @@ struct sort_t {
 
 // functions
 
+extern void sort_alloc   ();
 extern void sort_init    (int ThreadId);
 
 extern void sort_init    (sort_t * sort, board_t * board, const attack_t * attack, int depth, int height, int trans_killer, int last_move, int ThreadId);
@@ -53,6 +54,8 @@ extern void history_reset  (int move, const board_t * board, int ThreadId);
 
 extern void note_moves   (list_t * list, const board_t * board, int height, int trans_killer, int ThreadId);
 
+extern void sort_stats   ();
+
 #endif // !defined SORT_H
 
 // end of sort.h
@@ -56,6 +56,7 @@ extern void trans_inc_date (trans_t * trans);
 
 extern void trans_store    (trans_t * trans, uint64 key, int move, int depth, int flags, int value);
 extern bool trans_retrieve (trans_t * trans, entry_t ** found_entry, uint64 key, int * move, int * depth, int * flags, int * value);
+extern void trans_prefetch (trans_t * trans, uint64 key);
 
 extern void trans_stats    (const trans_t * trans);
 
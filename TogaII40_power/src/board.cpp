@@ -195,6 +195,8 @@ void board_clear(board_t * board) {
    board->flags = FlagsNone;
    board->ep_square = SquareNone;
    board->ply_nb = 0;
+
+   board->thread = 0;
 }
 
 // board_copy()
@@ -3,10 +3,8 @@
 
 // includes
 
-#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
-#include <cstring>
 
 #include "board.h"
 #include "book.h"
@@ -26,7 +24,8 @@ struct entry_t {
 
 // variables
 
-static FILE * BookFile;
+static const uint8 * BookData; // mapped read-only, pages are faulted in by the probes
+static uint64 BookBytes;
 static int BookSize;
 
 // prototypes
@@ -34,7 +33,7 @@ static int BookSize;
 static int    find_pos     (uint64 key);
 
 static void   read_entry   (entry_t * entry, int n);
-static uint64 read_integer (FILE * file, int size);
+static uint64 read_integer (const uint8 * data, int size);
 
 // functions
 
@@ -42,7 +41,8 @@ static uint64 read_integer (FILE * file, int size);
 
 void book_init() {
 
-   BookFile = NULL;
+   BookData = NULL;
+   BookBytes = 0;
    BookSize = 0;
 }
 
@@ -52,27 +52,19 @@ void book_open(const char file_name[]) {
 
    ASSERT(file_name!=NULL);
 
-   BookFile = fopen(file_name,"rb");
-
-   if (BookFile != NULL) {
-
-      if (fseek(BookFile,0,SEEK_END) == -1) {
-         my_fatal("book_open(): fseek(): %s\n",strerror(errno));
-      }
-
-      BookSize = ftell(BookFile) / 16;
-      if (BookSize == -1) my_fatal("book_open(): ftell(): %s\n",strerror(errno));
-   }
+   BookData = (const uint8 *) my_file_map(file_name,&BookBytes);
+   BookSize = int(BookBytes / 16);
 }
 
 // book_close()
 
 void book_close() {
 
-   if (BookFile != NULL && fclose(BookFile) == EOF) {
-      my_fatal("book_close(): fclose(): %s\n",strerror(errno));
-   }
-   BookFile = NULL;
+   if (BookData != NULL) my_file_unmap(BookData,BookBytes);
+
+   BookData = NULL;
+   BookBytes = 0;
+   BookSize = 0;
 }
 
 // book_move()
@@ -90,7 +82,7 @@ int book_move(board_t * board) {
 
    ASSERT(board!=NULL);
 
-   if (BookFile != NULL && BookSize != 0) {
+   if (BookData != NULL && BookSize != 0) {
 
       // draw a move according to a fixed probability distribution
 
@@ -148,6 +140,11 @@ static int find_pos(uint64 key) {
       mid = (left + right) / 2;
       ASSERT(mid>=left&&mid<right);
 
+      // fetch both possible next probes while this one is compared
+
+      PREFETCH(&BookData[uint64((left+mid)/2)*16]);
+      PREFETCH(&BookData[uint64((mid+1+right)/2)*16]);
+
       read_entry(entry,mid);
 
       if (key <= entry->key) {
@@ -168,49 +165,38 @@ static int find_pos(uint64 key) {
 
 static void read_entry(entry_t * entry, int n) {
 
+   const uint8 * data;
+
    ASSERT(entry!=NULL);
    ASSERT(n>=0&&n<BookSize);
 
-   ASSERT(BookFile!=NULL);
+   ASSERT(BookData!=NULL);
 
-   if (fseek(BookFile,n*16,SEEK_SET) == -1) {
-      my_fatal("read_entry(): fseek(): %s\n",strerror(errno));
-   }
+   data = &BookData[uint64(n)*16];
 
-   entry->key   = read_integer(BookFile,8);
-   entry->move  = read_integer(BookFile,2);
-   entry->count = read_integer(BookFile,2);
-   entry->n     = read_integer(BookFile,2);
-   entry->sum   = read_integer(BookFile,2);
+   entry->key   = read_integer(&data[0],8);
+   entry->move  = read_integer(&data[8],2);
+   entry->count = read_integer(&data[10],2);
+   entry->n     = read_integer(&data[12],2);
+   entry->sum   = read_integer(&data[14],2);
 }
 
 // read_integer()
 
-static uint64 read_integer(FILE * file, int size) {
+static uint64 read_integer(const uint8 * data, int size) {
 
    uint64 n;
    int i;
-   int b;
 
-   ASSERT(file!=NULL);
+   ASSERT(data!=NULL);
    ASSERT(size>0&&size<=8);
 
+   // big-endian, like the PolyGlot file format
+
    n = 0;
 
    for (i = 0; i < size; i++) {
-
-      b = fgetc(file);
-
-      if (b == EOF) {
-         if (feof(file)) {
-            my_fatal("read_integer(): fgetc(): EOF reached\n");
-         } else { // error
-            my_fatal("read_integer(): fgetc(): %s\n",strerror(errno));
-         }
-      }
-
-      ASSERT(b>=0&&b<256);
-      n = (n << 8) | b;
+      n = (n << 8) | data[i];
    }
 
    return n;
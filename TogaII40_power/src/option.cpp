@@ -24,7 +24,7 @@ struct option_t {
 
 static option_t Option[] = {
 
-#ifdef _WIN64
+#if defined(_WIN64) || defined(__LP64__)
    { "Hash", true, "128", "spin", "min 4 max 16384", NULL },
 #else
    { "Hash", true, "64", "spin", "min 4 max 1024", NULL },
@@ -84,6 +84,10 @@ static option_t Option[] = {
    { "Toga Rook Pawn Endgame Penalty",  true, "10",    "spin",  "min 0 max 100", NULL },
    
    { "Number of Threads",   true, "1",   "spin",  "min 1 max 64", NULL },
+
+   // per-thread evaluation caches in kB
+   { "Pawn Hash",     true, "256", "spin", "min 1 max 65536", NULL },
+   { "Material Hash", true, "4",   "spin", "min 1 max 65536", NULL },
    
    { NULL, false, NULL, NULL, NULL, NULL, },
 };
@@ -22,11 +22,9 @@
 
 // constants
 
-static const bool UseModulo = false;
-
 static const int DateSize = 16;
 
-static const int ClusterSize = 4; // TODO: unsigned?
+static const int ClusterSize = 4; // 4 * 16 bytes = one cache line
 
 static const bool AlwaysWrite = true; //was true
 
@@ -61,10 +59,16 @@ static const int DepthNone = -128;
    uint16 nproc; 
 };*/
 
+struct cluster_t {
+   entry_t entry[ClusterSize];
+};
+
 struct trans { // HACK: typedef'ed in trans.h
-   entry_t * table;
-   uint32 size;
-   uint32 mask;
+   cluster_t * table; // page aligned
+   uint64 bytes;
+   uint32 size; // entries
+   uint32 cluster_nb; // any number, the key is scaled to it
+   bool huge; // backed by large pages
    int date;
    int age[DateSize];
    uint32 used;
@@ -100,7 +104,7 @@ bool trans_is_ok(const trans_t * trans) {
 
    if (trans->table == NULL) return false;
    if (trans->size == 0) return false;
-   if (trans->mask == 0 || trans->mask >= trans->size) return false;
+   if (trans->cluster_nb == 0 || trans->size != trans->cluster_nb * ClusterSize) return false;
    if (trans->date >= DateSize) return false;
 
    for (date = 0; date < DateSize; date++) {
@@ -117,9 +121,12 @@ void trans_init(trans_t * trans) {
    ASSERT(trans!=NULL);
 
    ASSERT(sizeof(entry_t)==16);
+   ASSERT(sizeof(cluster_t)==64);
 
    trans->size = 0;
-   trans->mask = 0;
+   trans->cluster_nb = 0;
+   trans->bytes = 0;
+   trans->huge = false;
    trans->table = NULL;
 
    trans_set_date(trans,0);
@@ -137,28 +144,27 @@ void trans_alloc(trans_t * trans) {
 
    ASSERT(trans!=NULL);
 
-   // Set a smaller hash size (e.g., 1 MB)
-   target = 4 * 1024 * 1024; // 1 MB
-
-   for (size = 1; size != 0 && size <= target; size *= 2)
-      ;
+   // the "Hash" option in MB, all of it (no power-of-two rounding)
 
-   size /= 2;
-   ASSERT(size>0&&size<=target);
+   target = option_get_int("Hash");
+   if (target < 4) target = 16;
+   target *= 1024 * 1024;
 
    // allocate table
 
-   size /= sizeof(entry_t);
-   ASSERT(size!=0&&(size&(size-1))==0); // power of 2
+   size = target / sizeof(cluster_t);
+   if (size > 0xFFFFFFFF / ClusterSize) size = 0xFFFFFFFF / ClusterSize;
+   ASSERT(size!=0);
 
-   trans->size = (uint32) size + (ClusterSize - 1); // HACK to avoid testing for end of table
-   trans->mask = (uint32) size - 1;
+   trans->size = (uint32) size * ClusterSize;
+   trans->cluster_nb = (uint32) size;
+   trans->bytes = size * sizeof(cluster_t);
 
-   trans->table = (entry_t *)my_malloc(Trans->size*sizeof(entry_t));
+   trans->table = (cluster_t *) my_large_malloc(trans->bytes,&trans->huge);
 
    trans_clear(trans);
 
-   ASSERT(trans_is_ok());
+   ASSERT(trans_is_ok(trans));
 }
 
 // trans_free()
@@ -167,11 +173,13 @@ void trans_free(trans_t * trans) {
 
    ASSERT(trans_is_ok(trans));
 
-   my_free(trans->table);
+   my_large_free(trans->table,trans->bytes);
 
    trans->table = NULL;
+   trans->bytes = 0;
    trans->size = 0;
-   trans->mask = 0;
+   trans->cluster_nb = 0;
+   trans->huge = false;
 }
 
 // trans_clear()
@@ -193,7 +201,9 @@ void trans_clear(trans_t * trans) {
       
    ASSERT(entry_is_ok(clear_entry));
 
-   entry = trans->table;
+   if (trans->table == NULL) return;
+
+   entry = trans->table[0].entry;
 
    for (index = 0; index < trans->size; index++) {
       *entry++ = *clear_entry;
@@ -396,20 +406,33 @@ bool trans_retrieve(trans_t * trans, entry_t ** found_entry, uint64 key, int * m
    return false;
 }
 
+// trans_prefetch()
+
+void trans_prefetch(trans_t * trans, uint64 key) {
+
+   ASSERT(trans!=NULL);
+
+   // called from move_do(), possibly before the table exists
+
+   if (trans->table != NULL) PREFETCH(trans_entry(trans,key));
+}
+
 // trans_stats()
 
 void trans_stats(const trans_t * trans) {
 
    double full;
-   // double hit, collision;
+   double hit, collision;
 
    ASSERT(trans_is_ok(trans));
 
    full = double(trans->used) / double(trans->size);
-   // hit = double(trans->read_hit) / double(trans->read_nb);
-   // collision = double(trans->write_collision) / double(trans->write_nb);
+   if (full > 1.0) full = 1.0; // racy counter with several threads
+   hit = (trans->read_nb == 0) ? 0.0 : double(trans->read_hit) / double(trans->read_nb);
+   collision = (trans->write_nb == 0) ? 0.0 : double(trans->write_collision) / double(trans->write_nb);
 
    send("info hashfull %.0f",full*1000.0);
+   send("info string hash " S64_FORMAT " MB%s hit %.1f%% collision %.1f%%",sint64(trans->bytes>>20),(trans->huge)?" (large pages)":"",hit*100.0,collision*100.0);
 }
 
 // trans_entry()
@@ -420,15 +443,13 @@ static entry_t * trans_entry(trans_t * trans, uint64 key) {
 
    ASSERT(trans_is_ok(trans));
 
-   if (UseModulo) {
-      index = key % (trans->mask + 1);
-   } else {
-      index = key & trans->mask;
-   }
+   // scale the upper half of the key to the cluster count
+
+   index = uint32(((key >> 32) * trans->cluster_nb) >> 32);
 
-   ASSERT(index<=trans->mask);
+   ASSERT(index<trans->cluster_nb);
 
-   return &trans->table[index];
+   return trans->table[index].entry;
 }
 
 // entry_is_ok()
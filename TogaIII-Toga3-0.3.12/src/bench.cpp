@@ -0,0 +1,229 @@
+
+// bench.cpp
+
+// includes
+
+#include "bench.h"
+#include "eval_cache.h"
+#include "fen.h"
+#include "option.h"
+#include "protocol.h"
+#include "search.h"
+#include "trans.h"
+#include "util.h"
+
+// constants
+
+// the Stockfish bench suite, so node counts can be compared across the trees
+
+static const char * const BenchFen[] = {
+   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+   "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+   "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+   "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+   "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+   "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+   "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+   "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+   "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+   "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+   "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+   "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+   "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+   "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+   NULL,
+};
+
+static const int SmpThreads[] = { 1, 2, 4, 8, 0 };
+
+// types
+
+struct bench_result_t {
+   sint64 node_nb;
+   sint64 eval_nb[EvalPathNb];
+   double time;
+};
+
+// prototypes
+
+static void bench_setup    (int threads, int hash);
+static void bench_position (const char fen[], int depth, bench_result_t * result);
+
+// functions
+
+// bench_setup()
+
+static void bench_setup(int threads, int hash) {
+
+   char string[16];
+
+   ASSERT(threads>=1);
+
+   option_set("OwnBook","false");
+
+   if (hash >= 4 && hash != option_get_int("Hash")) {
+      sprintf(string,"%d",hash);
+      option_set("Hash",string);
+      trans_free(Trans);
+      trans_alloc(Trans);
+   }
+
+   if (threads > MaxThreads) threads = MaxThreads;
+
+   sprintf(string,"%d",threads);
+   option_set("Number of Threads",string);
+   if (threads != NumberThreads) threads_set(threads);
+}
+
+// bench_position()
+
+static void bench_position(const char fen[], int depth, bench_result_t * result) {
+
+   int ThreadId, path;
+
+   ASSERT(fen!=NULL);
+   ASSERT(result!=NULL);
+
+   // every position starts from empty tables so that one thread is reproducible
+
+   trans_clear(Trans);
+   eval_cache_clear();
+
+   search_clear();
+   board_from_fen(SearchInput->board,fen);
+
+   SearchInput->depth_is_limited = true;
+   SearchInput->depth_limit = depth;
+
+   SearchInput->quiet = true;
+   search();
+   SearchInput->quiet = false;
+
+   result->node_nb = 0;
+   for (path = 0; path < EvalPathNb; path++) result->eval_nb[path] = 0;
+
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+      search_update_current(ThreadId);
+      result->node_nb += SearchCurrent[ThreadId]->node_nb;
+      for (path = 0; path < EvalPathNb; path++) result->eval_nb[path] += SearchCurrent[ThreadId]->eval_nb[path];
+   }
+
+   result->time = SearchCurrent[0]->time;
+}
+
+// bench()
+
+void bench(int depth, int threads, int hash) {
+
+   int pos, path;
+   int old_threads, old_hash;
+   bool old_book;
+   bench_result_t result[1];
+   sint64 node_nb, eval_nb[EvalPathNb], eval_total;
+   double time;
+
+   if (depth < 1) depth = 1;
+   if (depth >= DepthMax) depth = DepthMax - 1;
+   if (threads < 1) threads = 1;
+
+   old_threads = NumberThreads;
+   old_hash = option_get_int("Hash");
+   old_book = option_get_bool("OwnBook");
+
+   bench_setup(threads,hash);
+
+   node_nb = 0;
+   for (path = 0; path < EvalPathNb; path++) eval_nb[path] = 0;
+   time = 0.0;
+
+   for (pos = 0; BenchFen[pos] != NULL; pos++) {
+
+      bench_position(BenchFen[pos],depth,result);
+
+      send("info string bench %2d %-72s nodes %10.0f time %6.0f ms",
+           pos+1,BenchFen[pos],double(result->node_nb),result->time*1000.0);
+
+      node_nb += result->node_nb;
+      for (path = 0; path < EvalPathNb; path++) eval_nb[path] += result->eval_nb[path];
+      time += result->time;
+   }
+
+   eval_total = 0;
+   for (path = 0; path < EvalPathNb; path++) eval_total += eval_nb[path];
+   if (eval_total == 0) eval_total = 1;
+
+   if (time <= 0.0) time = 0.001;
+
+   send("info string bench depth %d threads %d hash %d MB",depth,NumberThreads,option_get_int("Hash"));
+   send("info string bench eval lazy " S64_FORMAT " (%.1f%%) nnue " S64_FORMAT " (%.1f%%) classical " S64_FORMAT " (%.1f%%)",
+        eval_nb[EvalLazy],double(eval_nb[EvalLazy])*100.0/double(eval_total),
+        eval_nb[EvalNnue],double(eval_nb[EvalNnue])*100.0/double(eval_total),
+        eval_nb[EvalClassical],double(eval_nb[EvalClassical])*100.0/double(eval_total));
+   send("info string bench time %.0f ms nps %.0f",time*1000.0,double(node_nb)/time);
+
+   // last on its own line, like Stockfish, for scripts that compare node counts
+
+   send("Nodes searched: " S64_FORMAT,node_nb);
+
+   // back to the GUI's settings
+
+   bench_setup(old_threads,old_hash);
+   option_set("OwnBook",old_book?"true":"false");
+
+   search_clear();
+}
+
+// bench_smp()
+
+void bench_smp(int depth) {
+
+   int i, pos;
+   int threads;
+   bench_result_t result[1];
+   sint64 node_nb;
+   double time, base_time, base_speed, speed;
+
+   if (depth < 1) depth = 1;
+   if (depth >= DepthMax) depth = DepthMax - 1;
+
+   // "speedup" is time to depth against one thread, "nps ratio" the raw
+   // throughput; lazy SMP searches wider, so the first is always the smaller
+
+   send("smp bench: depth %d, hash %d MB, %d NUMA node(s)",depth,option_get_int("Hash"),my_numa_node_nb());
+   send("threads      time ms           nodes          nps  speedup  nps ratio");
+
+   base_time = 0.0;
+   base_speed = 0.0;
+
+   for (i = 0; SmpThreads[i] != 0 && SmpThreads[i] <= MaxThreads; i++) {
+
+      threads = SmpThreads[i];
+
+      bench_setup(threads,0);
+
+      node_nb = 0;
+      time = 0.0;
+
+      for (pos = 0; BenchFen[pos] != NULL; pos++) {
+         bench_position(BenchFen[pos],depth,result);
+         node_nb += result->node_nb;
+         time += result->time;
+      }
+
+      if (time <= 0.0) time = 0.001;
+      speed = double(node_nb) / time;
+
+      if (threads == 1) {
+         base_time = time;
+         base_speed = speed;
+      }
+
+      send("%7d %12.0f %15.0f %12.0f %8.2f %10.2f",
+           threads,time*1000.0,double(node_nb),speed,base_time/time,speed/base_speed);
+   }
+}
+
+// end of bench.cpp
+
@@ -0,0 +1,24 @@
+
+// bench.h
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// includes
+
+#include "util.h"
+
+// constants
+
+const int BenchDepth = 10;
+const int BenchHash = 16; // MB
+
+// functions
+
+extern void bench     (int depth, int threads, int hash);
+extern void bench_smp (int depth);
+
+#endif // !defined BENCH_H
+
+// end of bench.h
+
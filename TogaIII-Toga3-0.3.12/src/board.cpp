@@ -14,6 +14,7 @@
 #include "move_evasion.h"
 #include "move_gen.h"
 #include "move_legal.h"
+#include "nnue/nnue.h"
 #include "pawn.h" // TODO: bit.h
 #include "piece.h"
 #include "pst.h"
@@ -195,6 +196,9 @@ void board_clear(board_t * board) {
    board->flags = FlagsNone;
    board->ep_square = SquareNone;
    board->ply_nb = 0;
+
+   board->nnue = NULL;
+   board->nnue_sp = 0;
 }
 
 // board_copy()
@@ -371,6 +375,23 @@ void board_init_list(board_t * board) {
    ASSERT(board_is_ok(board));
 }
 
+// board_nnue_attach()
+
+void board_nnue_attach(board_t * board, NNUEdata * stack) {
+
+   ASSERT(board!=NULL);
+   ASSERT(stack!=NULL);
+
+   // the root accumulator is refreshed on the first evaluation
+
+   board->nnue = stack;
+   board->nnue_sp = 0;
+
+   stack[0].accumulator.computedAccumulation = 0;
+   stack[0].dirtyPiece.dirtyNum = 0;
+   stack[0].dirtyPiece.pc[0] = 0;
+}
+
 // board_is_legal()
 
 bool board_is_legal(const board_t * board) {
@@ -38,12 +38,14 @@ const int FlagsBlackQueenCastle = 1 << 3;
 
 const int StackSize = 4096;
 
+// types
+
+struct NNUEdata; // nnue/nnue.h
+
 // macros
 
 #define KING_POS(board,colour) ((board)->piece[colour][0])
 
-// types
-
 struct board_t {
 
    int piece_material[ColourNb]; // Thomas
@@ -79,6 +81,9 @@ struct board_t {
    uint64 material_key;
 
    uint64 stack[StackSize];
+
+   NNUEdata * nnue; // per-ply accumulator stack owned by the search, NULL if none
+   int nnue_sp;
 };
 
 // functions
@@ -90,6 +95,8 @@ extern void board_copy          (board_t * dst, const board_t * src);
 
 extern void board_init_list     (board_t * board);
 
+extern void board_nnue_attach   (board_t * board, NNUEdata * stack);
+
 extern bool board_is_legal      (const board_t * board);
 extern bool board_is_check      (const board_t * board);
 extern bool board_is_mate       (const board_t * board);
@@ -9,11 +9,13 @@
 #include "board.h"
 #include "colour.h"
 #include "eval.h"
+#include "eval_cache.h"
 #include "material.h"
 #include "move.h"
 #include "option.h"
 #include "pawn.h"
 #include "piece.h"
+#include "protocol.h"
 #include "see.h"
 #include "util.h"
 #include "value.h"
@@ -53,6 +55,8 @@ const int KnightOutpostMatrix[2][64] = {
 static int lazy_eval_cutoff = 200; /* Thomas */
 static int second_lazy_eval_cutoff = 125; /* JD */
 static bool LazyEval = false; // true
+static bool UseNnue = true;
+static int nnue_lazy_margin = 800; // |material+PST| above this skips NNUE outside PV nodes
 //static bool KingSafety = false; // true
 //static int KingSafetyMargin = 1600;
 //static bool king_is_safe[ColourNb];
@@ -178,6 +182,8 @@ static void eval_king          (const board_t * board, const material_info_t * m
 static void eval_passer        (const board_t * board, const pawn_info_t * pawn_info, int * opening, int * endgame);
 static void eval_pattern       (const board_t * board, int * opening, int * endgame);
 
+static int  eval_bound         (int eval, const int mul[ColourNb], int turn);
+
 static bool unstoppable_passer (const board_t * board, int pawn, int colour);
 static bool king_passer        (const board_t * board, int pawn, int colour);
 static bool free_passer        (const board_t * board, int pawn, int colour);
@@ -217,6 +223,34 @@ void eval_parameter() {
    LazyEval = option_get_bool("Toga Lazy Eval"); /* Thomas */
    lazy_eval_cutoff = option_get_int("Toga Lazy Eval Margin");
    second_lazy_eval_cutoff = option_get_int("Toga Lazy Eval Mobility Margin");
+
+   UseNnue = option_get_bool("Use NNUE");
+   nnue_lazy_margin = option_get_int("NNUE Lazy Margin");
+}
+
+// eval_stats()
+
+void eval_stats() {
+
+   sint64 nb[EvalPathNb];
+   sint64 total;
+   int ThreadId, path;
+
+   total = 0;
+   for (path = 0; path < EvalPathNb; path++) {
+      nb[path] = 0;
+      for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+         nb[path] += SearchCurrent[ThreadId]->eval_nb[path];
+      }
+      total += nb[path];
+   }
+
+   if (total == 0) return;
+
+   send("info string eval lazy %.1f%% nnue %.1f%% classical %.1f%%",
+        double(nb[EvalLazy])*100.0/double(total),
+        double(nb[EvalNnue])*100.0/double(total),
+        double(nb[EvalClassical])*100.0/double(total));
 }
 
 // eval_init()
@@ -357,9 +391,6 @@ void eval_init() {
 
 // eval_nnue()
 
-// Stockfish NNUE piece encoding
-int nnue_pieces[13] = {6, 12, 5, 11, 4, 10, 3, 9, 2, 8, 1, 7, 0};
-
 int eval_nnue(board_t * board) {
   // NNUE probe arrays
   int pieces[33];
@@ -415,6 +446,19 @@ int eval_nnue(board_t * board) {
   pieces[index] = 0;
   squares[index] = 0;
 
+  // incremental update through the search accumulator stack
+
+  if (board->nnue != NULL) {
+    NNUEdata * nnue_data[3];
+    int sp = board->nnue_sp;
+
+    nnue_data[0] = &board->nnue[sp];
+    nnue_data[1] = (sp >= 1) ? &board->nnue[sp-1] : NULL;
+    nnue_data[2] = (sp >= 2) ? &board->nnue[sp-2] : NULL;
+
+    return evaluate_nnue_incremental(board->turn, pieces, squares, nnue_data);
+  }
+
   int retval = evaluate_nnue(board->turn, pieces, squares);
   return retval;
   
@@ -432,6 +476,8 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
    int eval;
    int wb, bb;
    int lazy_eval; // Thomas
+   bool pv;
+   bool pawn_done;
 
    ASSERT(board!=NULL);
 
@@ -443,6 +489,8 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
    opening = 0;
    endgame = 0;
 
+   SearchCurrent[ThreadId]->eval_exact = true; // reset by the lazy exits
+
    // material
 
    material_get_info(mat_info,board,ThreadId);
@@ -460,7 +508,14 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
    opening += board->opening;
    endgame += board->endgame;
 
-   // draw
+   // draw (the single-file pawn patterns need the pawn info early)
+
+   pawn_done = false;
+
+   if (((mat_info->cflags[White] | mat_info->cflags[Black]) & (MatRookPawnFlag | MatBishopFlag)) != 0) {
+      pawn_get_info(pawn_info,board,ThreadId);
+      pawn_done = true;
+   }
 
    eval_draw(board,mat_info,pawn_info,mul);
 
@@ -479,6 +534,44 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
 		endgame -= 10;
    } 
 
+   // hybrid gate: NNUE is only worth its cost when the material+PST
+   // estimate is not already decisive, or at PV nodes (open window)
+
+   if (UseNnue && (board->piece_size[White] + board->piece_size[Black]) > 6) {
+
+      lazy_eval = eval_bound(((opening * (256 - phase)) + (endgame * phase)) / 256,mul,board->turn);
+      pv = (beta > alpha + 1);
+
+      if (!pv) {
+
+         if (abs(lazy_eval) >= nnue_lazy_margin) {
+            SearchCurrent[ThreadId]->eval_nb[EvalLazy]++;
+            SearchCurrent[ThreadId]->eval_exact = false;
+            return lazy_eval;
+         }
+
+         // Lazy Eval (Thomas)
+
+         if (LazyEval && board->piece_size[White] > 3 && board->piece_size[Black] > 3
+          && (lazy_eval - lazy_eval_cutoff >= beta || lazy_eval + lazy_eval_cutoff <= alpha)) {
+            SearchCurrent[ThreadId]->eval_nb[EvalLazy]++;
+            SearchCurrent[ThreadId]->eval_exact = false;
+            return lazy_eval;
+         }
+      }
+
+      SearchCurrent[ThreadId]->eval_nb[EvalNnue]++;
+
+      if (!eval_cache_probe(board->key,&eval,ThreadId)) {
+         eval = eval_nnue(board);
+         eval_cache_store(board->key,eval,ThreadId);
+      }
+
+      return eval;
+   }
+
+   SearchCurrent[ThreadId]->eval_nb[EvalClassical]++;
+
    eval_pattern(board,&opening,&endgame);
 
    // Lazy Eval (Thomas) 
@@ -491,22 +584,18 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
      ASSERT(eval>=-ValueEvalInf&&eval<=+ValueEvalInf);
 
 	 if (COLOUR_IS_BLACK(board->turn)) lazy_eval = -lazy_eval;
+	 SearchCurrent[ThreadId]->eval_exact = false;
 	 if (lazy_eval - lazy_eval_cutoff >= beta)
 		return (lazy_eval);
 	 if (lazy_eval + lazy_eval_cutoff <= alpha)
 		return (lazy_eval);  
+	 SearchCurrent[ThreadId]->eval_exact = true;
  
    } 
 
+   // pawns (moved JD: very small gain), unless already probed for the draw patterns
 
-   // nnue post lazy
-   if ((board->piece_size[White] + board->piece_size[Black]) > 6) {
-     return eval_nnue(board);
-   }
-   
-   // pawns (moved JD: very small gain)
-
-   pawn_get_info(pawn_info,board,ThreadId);
+   if (!pawn_done) pawn_get_info(pawn_info,board,ThreadId);
 
    opening += pawn_info->opening;
    endgame += pawn_info->endgame;
@@ -526,10 +615,12 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
      ASSERT(eval>=-ValueEvalInf&&eval<=+ValueEvalInf);
 
 	 if (COLOUR_IS_BLACK(board->turn)) lazy_eval = -lazy_eval;
+	 SearchCurrent[ThreadId]->eval_exact = false;
 	 if (lazy_eval - second_lazy_eval_cutoff >= beta)
 		return (lazy_eval);
 	 if (lazy_eval + second_lazy_eval_cutoff <= alpha)
 		return (lazy_eval);  
+	 SearchCurrent[ThreadId]->eval_exact = true;
    }
    
    eval_piece(board,mat_info,pawn_info,&opening,&endgame); 
@@ -554,6 +645,16 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
       }
    }
 
+   return eval_bound(eval,mul,board->turn);
+}
+
+// eval_bound()
+
+static int eval_bound(int eval, const int mul[ColourNb], int turn) {
+
+   ASSERT(mul!=NULL);
+   ASSERT(COLOUR_IS_OK(turn));
+
    // draw bound
 
    if (eval > ValueDraw) {
@@ -571,7 +672,7 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
 
    // turn
 
-   if (COLOUR_IS_BLACK(board->turn)) eval = -eval;
+   if (COLOUR_IS_BLACK(turn)) eval = -eval;
 
    ASSERT(!value_is_mate(eval));
 
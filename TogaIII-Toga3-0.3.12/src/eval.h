@@ -15,6 +15,7 @@
 
 extern void eval_init ();
 extern void eval_parameter ();
+extern void eval_stats     ();
 
 extern int  eval      (board_t * board, int alpha, int beta, int ThreadId);
 
@@ -0,0 +1,196 @@
+
+// eval_cache.cpp
+
+// includes
+
+#include <cstring>
+
+#include "eval_cache.h"
+#include "option.h"
+#include "protocol.h"
+#include "search.h"
+#include "util.h"
+
+// constants
+
+static const uint32 EntryMin = 4096; // per thread
+static const int BucketSize = 4; // entries, two buckets per cache line
+
+// macros
+
+// an entry is the upper 48 bits of the key and the score in the lower 16,
+// written with a single 64-bit store so no lock is needed
+
+// the table is 4-way set associative: a bucket keeps its entries from the
+// most to the least recently used, a hit moves the entry to the front and a
+// store evicts the last one
+
+#define ENTRY_LOCK(key)          ((key)&~uint64(0xFFFF))
+#define ENTRY_VALUE(entry)       (sint16(uint16(entry)))
+#define ENTRY_MAKE(key,value)    (ENTRY_LOCK(key)|uint64(uint16(value)))
+
+// types
+
+struct eval_cache_t {
+   uint64 * table; // 64-byte aligned, 8 entries per cache line
+   void * memory;
+   uint32 size;
+   uint32 mask; // bucket index
+   sint64 read_nb;
+   sint64 read_hit;
+};
+
+// variables
+
+static eval_cache_t EvalCache[MaxThreads][1];
+
+// functions
+
+// eval_cache_alloc()
+
+// run by the owning thread (see threads_set()), so the table is first
+// touched on that thread's NUMA node
+
+void eval_cache_alloc(int ThreadId) {
+
+   eval_cache_t * cache;
+   uint64 target;
+   uint32 size;
+
+   ASSERT(sizeof(uint64)==8);
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+
+   // the "NNUE Eval Cache" budget is shared by all threads
+
+   target = (uint64(option_get_int("NNUE Eval Cache")) * 1024 * 1024) / NumberThreads / sizeof(uint64);
+
+   for (size = 1; size * 2 <= target; size *= 2)
+      ;
+   if (size < EntryMin) size = EntryMin;
+
+   cache = EvalCache[ThreadId];
+
+   if (cache->table != NULL && cache->size == size) return; // already the right size
+
+   eval_cache_free(ThreadId);
+
+   cache->size = size;
+   cache->mask = size / BucketSize - 1;
+   cache->memory = my_malloc(size * sizeof(uint64) + 64);
+   cache->table = (uint64 *) ((uintptr_t(cache->memory) + 63) & ~uintptr_t(63));
+
+   memset(cache->table,0,cache->size*sizeof(uint64));
+
+   cache->read_nb = 0;
+   cache->read_hit = 0;
+}
+
+// eval_cache_free()
+
+void eval_cache_free(int ThreadId) {
+
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+
+   if (EvalCache[ThreadId]->memory != NULL) my_free(EvalCache[ThreadId]->memory);
+
+   EvalCache[ThreadId]->memory = NULL;
+   EvalCache[ThreadId]->table = NULL;
+}
+
+// eval_cache_clear()
+
+void eval_cache_clear() {
+
+   int ThreadId;
+
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+
+      if (EvalCache[ThreadId]->table != NULL) {
+         memset(EvalCache[ThreadId]->table,0,EvalCache[ThreadId]->size*sizeof(uint64));
+      }
+
+      EvalCache[ThreadId]->read_nb = 0;
+      EvalCache[ThreadId]->read_hit = 0;
+   }
+}
+
+// eval_cache_probe()
+
+bool eval_cache_probe(uint64 key, int * value, int ThreadId) {
+
+   eval_cache_t * cache;
+   uint64 * bucket;
+   uint64 entry;
+   int i;
+
+   ASSERT(value!=NULL);
+
+   cache = EvalCache[ThreadId];
+   if (cache->table == NULL) return false;
+
+   cache->read_nb++;
+
+   bucket = &cache->table[(uint32(key)&cache->mask)*BucketSize];
+
+   for (i = 0; i < BucketSize; i++) {
+
+      entry = bucket[i];
+
+      if (ENTRY_LOCK(entry) == ENTRY_LOCK(key) && entry != 0) {
+
+         for (; i > 0; i--) bucket[i] = bucket[i-1];
+         bucket[0] = entry;
+
+         cache->read_hit++;
+         *value = ENTRY_VALUE(entry);
+
+         return true;
+      }
+   }
+
+   return false;
+}
+
+// eval_cache_store()
+
+void eval_cache_store(uint64 key, int value, int ThreadId) {
+
+   eval_cache_t * cache;
+   uint64 * bucket;
+   int i;
+
+   ASSERT(value>=-32767&&value<=+32767);
+
+   cache = EvalCache[ThreadId];
+   if (cache->table == NULL) return;
+
+   bucket = &cache->table[(uint32(key)&cache->mask)*BucketSize];
+
+   for (i = BucketSize-1; i > 0; i--) bucket[i] = bucket[i-1];
+   bucket[0] = ENTRY_MAKE(key,value);
+}
+
+// eval_cache_stats()
+
+void eval_cache_stats() {
+
+   int ThreadId;
+   sint64 read_nb, read_hit;
+
+   read_nb = 0;
+   read_hit = 0;
+
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+      read_nb += EvalCache[ThreadId]->read_nb;
+      read_hit += EvalCache[ThreadId]->read_hit;
+   }
+
+   if (read_nb == 0) return;
+
+   send("info string eval cache %d kB/thread hit %.1f%%",
+        int(EvalCache[0]->size * sizeof(uint64) / 1024),
+        double(read_hit)*100.0/double(read_nb));
+}
+
+// end of eval_cache.cpp
+
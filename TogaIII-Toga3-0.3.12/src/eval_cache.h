@@ -0,0 +1,25 @@
+
+// eval_cache.h
+
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+
+// includes
+
+#include "util.h"
+
+// functions
+
+extern void eval_cache_alloc    (int ThreadId);
+extern void eval_cache_free     (int ThreadId);
+extern void eval_cache_clear    ();
+
+extern bool eval_cache_probe    (uint64 key, int * value, int ThreadId);
+extern void eval_cache_store    (uint64 key, int value, int ThreadId);
+
+extern void eval_cache_stats    ();
+
+#endif // !defined EVAL_CACHE_H
+
+// end of eval_cache.h
+
@@ -7,6 +7,7 @@
 #include <cstdlib>
 
 #include "attack.h"
+#include "bench.h"
 #include "book.h"
 #include "hash.h"
 #include "move_do.h"
@@ -15,6 +16,7 @@
 #include "piece.h"
 #include "protocol.h"
 #include "random.h"
+#include "search.h"
 #include "square.h"
 #include "trans.h"
 #include "util.h"
@@ -55,7 +57,57 @@ int main(int argc, char * argv[]) {
    
    book_init();
 
-   init_nnue_embedded();
+   search_init();
+
+   // "toga3 compactnet <file> [buckets]" writes a compact copy of the embedded net
+
+   if (argc >= 3 && my_string_equal(argv[1],"compactnet")) {
+      int buckets = (argc >= 4) ? atoi(argv[3]) : 16;
+      if (!write_compact_nnue(argv[2],buckets)) {
+         printf("cannot write %s (buckets must be a power of two up to 64)\n",argv[2]);
+         return EXIT_FAILURE;
+      }
+      printf("%s written with %d king buckets\n",argv[2],buckets);
+      return EXIT_SUCCESS;
+   }
+
+   // "toga3 mappednet <file>" writes a mapped (zero-copy) copy of the embedded net
+
+   if (argc >= 3 && my_string_equal(argv[1],"mappednet")) {
+      if (!write_mapped_nnue(argv[2])) {
+         printf("cannot write %s\n",argv[2]);
+         return EXIT_FAILURE;
+      }
+      printf("%s written\n",argv[2]);
+      return EXIT_SUCCESS;
+   }
+
+   // "toga3 nnuebench [evals]" times the NNUE kernels (ns/eval per instruction set)
+
+   if (argc >= 2 && my_string_equal(argv[1],"nnuebench")) {
+      bench_nnue((argc >= 3) ? atoi(argv[2]) : 100000);
+      return EXIT_SUCCESS;
+   }
+
+   // "toga3 bench [depth] [threads] [hash]" is the UCI "bench" command run once
+
+   if (argc >= 2 && my_string_equal(argv[1],"bench")) {
+      init();
+      bench((argc >= 3) ? atoi(argv[2]) : BenchDepth,(argc >= 4) ? atoi(argv[3]) : 1,(argc >= 5) ? atoi(argv[4]) : BenchHash);
+      threads_exit();
+      return EXIT_SUCCESS;
+   }
+
+   // "toga3 smpbench [depth]" times fixed-depth searches at 1/2/4/8 threads
+
+   if (argc >= 2 && my_string_equal(argv[1],"smpbench")) {
+      init();
+      bench_smp((argc >= 3) ? atoi(argv[2]) : BenchDepth);
+      threads_exit();
+      return EXIT_SUCCESS;
+   }
+
+   // the net is loaded after UCI options are parsed (NNUE File)
 
    // loop
 
@@ -98,54 +98,28 @@ void material_parameter() {
 
 void material_init() {
 
-	int ThreadId;
-
    // UCI options
 
    material_parameter();
-
-   // material table
-
-	for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		Material[ThreadId]->size = 0;
-		Material[ThreadId]->mask = 0;
-		Material[ThreadId]->table = NULL;
-	}
 }
 
 // material_alloc()
 
-void material_alloc() {
+// called once by the owning thread, so the table is local to its NUMA node
 
-	int ThreadId;
+void material_alloc(int ThreadId) {
 
    ASSERT(sizeof(entry_t)==16);
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+   ASSERT(Material[ThreadId]->table==NULL);
 
    if (UseTable) {
 
-		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-			Material[ThreadId]->size = TableSize;
-			Material[ThreadId]->mask = TableSize - 1;
-			Material[ThreadId]->table = (entry_t *) my_malloc((uint64) Material[ThreadId]->size*sizeof(entry_t));
-
-			material_clear(ThreadId);
-		}
-   }
-}
-
-// material_free()
+      Material[ThreadId]->size = TableSize;
+      Material[ThreadId]->mask = TableSize - 1;
+      Material[ThreadId]->table = (entry_t *) my_malloc((uint64) Material[ThreadId]->size*sizeof(entry_t));
 
-void material_free() {
-
-	int ThreadId;
-
-   ASSERT(sizeof(entry_t)==16);
-
-   if (UseTable) {
-
-		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		  my_free(Material[ThreadId]->table);
-		}
+      material_clear(ThreadId);
    }
 }
 
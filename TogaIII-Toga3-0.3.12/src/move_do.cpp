@@ -9,10 +9,13 @@
 #include "hash.h"
 #include "move.h"
 #include "move_do.h"
+#include "nnue_eval.h"
+#include "nnue/nnue.h"
 #include "pawn.h" // TODO: bit.h
 #include "piece.h"
 #include "pst.h"
 #include "random.h"
+#include "search.h"
 #include "util.h"
 #include "value.h"
 
@@ -26,6 +29,9 @@ static void square_clear (board_t * board, int square, int piece, bool update);
 static void square_set   (board_t * board, int square, int piece, int pos, bool update);
 static void square_move  (board_t * board, int from, int to, int piece, bool update);
 
+static DirtyPiece * nnue_push (board_t * board);
+static void dirty_add         (DirtyPiece * dp, int piece, int from_64, int to_64);
+
 // functions
 
 // move_do_init()
@@ -60,6 +66,7 @@ void move_do(board_t * board, int move, undo_t * undo) {
    int delta;
    int sq;
    int pawn, rook;
+   DirtyPiece * dp;
 
    ASSERT(board!=NULL);
    ASSERT(move_is_ok(move));
@@ -98,6 +105,15 @@ void move_do(board_t * board, int move, undo_t * undo) {
 	board->moving_piece = piece;
    ASSERT(COLOUR_IS(piece,me));
 
+   // NNUE accumulator stack (the moving piece must come first)
+
+   dp = NULL;
+
+   if (board->nnue != NULL) {
+      dp = nnue_push(board);
+      dirty_add(dp,piece,SQUARE_TO_64(from),SQUARE_TO_64(to));
+   }
+
    // update key stack
 
    ASSERT(board->sp<StackSize);
@@ -161,6 +177,7 @@ void move_do(board_t * board, int move, undo_t * undo) {
       undo->capture_pos = board->pos[sq];
 
       square_clear(board,sq,capture,true);
+      if (dp != NULL) dirty_add(dp,capture,SQUARE_TO_64(sq),64);
 
       board->ply_nb = 0; // conversion
       board->cap_sq = to;
@@ -185,6 +202,11 @@ void move_do(board_t * board, int move, undo_t * undo) {
 
       square_set(board,to,piece,pos,true);
 
+      if (dp != NULL) {
+         dp->to[0] = 64;
+         dirty_add(dp,piece,64,SQUARE_TO_64(to));
+      }
+
       board->cap_sq = to;
 
    } else {
@@ -202,12 +224,16 @@ void move_do(board_t * board, int move, undo_t * undo) {
 
       if (to == G1) {
          square_move(board,H1,F1,rook,true);
+         if (dp != NULL) dirty_add(dp,rook,SQUARE_TO_64(H1),SQUARE_TO_64(F1));
       } else if (to == C1) {
          square_move(board,A1,D1,rook,true);
+         if (dp != NULL) dirty_add(dp,rook,SQUARE_TO_64(A1),SQUARE_TO_64(D1));
       } else if (to == G8) {
          square_move(board,H8,F8,rook,true);
+         if (dp != NULL) dirty_add(dp,rook,SQUARE_TO_64(H8),SQUARE_TO_64(F8));
       } else if (to == C8) {
          square_move(board,A8,D8,rook,true);
+         if (dp != NULL) dirty_add(dp,rook,SQUARE_TO_64(A8),SQUARE_TO_64(D8));
       } else {
          ASSERT(false);
       }
@@ -309,6 +335,13 @@ void move_undo(board_t * board, int move, const undo_t * undo) {
    ASSERT(board->sp>0);
    board->sp--;
 
+   // NNUE accumulator stack
+
+   if (board->nnue != NULL) {
+      ASSERT(board->nnue_sp>0);
+      board->nnue_sp--;
+   }
+
    // debug
 
    ASSERT(board_is_ok(board));
@@ -341,6 +374,10 @@ void move_do_null(board_t * board, undo_t * undo) {
    ASSERT(board->sp<StackSize);
    board->stack[board->sp++] = board->key;
 
+   // NNUE accumulator stack (no dirty piece, the parent accumulator is reused)
+
+   if (board->nnue != NULL) nnue_push(board);
+
    // update turn
 
    board->turn = COLOUR_OPP(board->turn);
@@ -392,6 +429,13 @@ void move_undo_null(board_t * board, const undo_t * undo) {
    ASSERT(board->sp>0);
    board->sp--;
 
+   // NNUE accumulator stack
+
+   if (board->nnue != NULL) {
+      ASSERT(board->nnue_sp>0);
+      board->nnue_sp--;
+   }
+
    // debug
 
    ASSERT(board_is_ok(board));
@@ -745,5 +789,41 @@ static void square_move(board_t * board, int from, int to, int piece, bool updat
    }
 }
 
+// nnue_push()
+
+static DirtyPiece * nnue_push(board_t * board) {
+
+   NNUEdata * nnue;
+
+   ASSERT(board!=NULL);
+   ASSERT(board->nnue!=NULL);
+   ASSERT(board->nnue_sp+1<NnueStackSize);
+
+   nnue = &board->nnue[++board->nnue_sp];
+
+   nnue->accumulator.computedAccumulation = 0;
+   nnue->dirtyPiece.dirtyNum = 0;
+   nnue->dirtyPiece.pc[0] = 0;
+
+   return &nnue->dirtyPiece;
+}
+
+// dirty_add()
+
+static void dirty_add(DirtyPiece * dp, int piece, int from_64, int to_64) {
+
+   int n;
+
+   ASSERT(dp!=NULL);
+   ASSERT(piece_is_ok(piece));
+
+   n = dp->dirtyNum++;
+   ASSERT(n>=0&&n<3);
+
+   dp->pc[n] = nnue_pieces[PIECE_TO_12(piece)];
+   dp->from[n] = from_64; // 64 = added
+   dp->to[n] = to_64; // 64 = removed
+}
+
 // end of move_do.cpp
 
@@ -4,6 +4,9 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <chrono>
+
 //--------------------
 #ifdef _MSC_VER
 #  define USE_AVX2   1
@@ -15,7 +18,20 @@
 #endif
 //-------------------
 
-#if defined(USE_AVX2)
+// Runtime dispatch needs GCC/clang target attributes on x86
+#if defined(USE_DISPATCH) && !(defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#undef USE_DISPATCH
+#endif
+
+#if defined(USE_DISPATCH)
+// GCC 12 warns about the _mm256_undefined_si256() inside its own AVX-512
+// extract intrinsics once they are inlined (GCC bug 105593)
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 12
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+#include <immintrin.h>
+
+#elif defined(USE_AVX2)
 #include <immintrin.h>
 
 #elif defined(USE_SSE41)
@@ -47,14 +63,6 @@
 #define IS_KING(p) ( ((p) == wking) || ((p) == bking) )
 //-------------------
 
-// Old gcc on Windows is unable to provide a 32-byte aligned stack.
-// We need to hack around this when using AVX2 and AVX512.
-#if     defined(__GNUC__ ) && (__GNUC__ < 9) && defined(_WIN32) \
-    && !defined(__clang__) && !defined(__INTEL_COMPILER) \
-    &&  defined(USE_AVX2)
-#define ALIGNMENT_HACK
-#endif
-
 #if defined(USE_NEON) && !defined(IS_64BIT)
 INLINE int16x8_t vmovl_high_s16(int8x16_t v)
 {
@@ -98,1186 +106,735 @@ enum {
   FtOutDims = kHalfDimensions * 2
 };
 
-// USE_MMX generates _mm_empty() instructions, so undefine if not needed
-#if defined(USE_SSE2)
-#undef USE_MMX
-#endif
-
-static_assert(kHalfDimensions % 256 == 0, "kHalfDimensions should be a multiple of 256");
-
-#define VECTOR
-
-#ifdef USE_AVX512
-#define SIMD_WIDTH 512
-typedef __m512i vec16_t;
-typedef __m512i vec8_t;
-typedef __mmask64 mask_t;
-#define vec_add_16(a,b) _mm512_add_epi16(a,b)
-#define vec_sub_16(a,b) _mm512_sub_epi16(a,b)
-#define vec_packs(a,b) _mm512_packs_epi16(a,b)
-#define vec_mask_pos(a) _mm512_cmpgt_epi8_mask(a,_mm512_setzero_si512())
-#define NUM_REGS 8 // only 8 are needed
-
-#elif USE_AVX2
-#define SIMD_WIDTH 256
-typedef __m256i vec16_t;
-typedef __m256i vec8_t;
-typedef uint32_t mask_t;
-#define vec_add_16(a,b) _mm256_add_epi16(a,b)
-#define vec_sub_16(a,b) _mm256_sub_epi16(a,b)
-#define vec_packs(a,b) _mm256_packs_epi16(a,b)
-#define vec_mask_pos(a) _mm256_movemask_epi8(_mm256_cmpgt_epi8(a,_mm256_setzero_si256()))
-#define NUM_REGS 16
-
-#elif USE_SSE2
-#define SIMD_WIDTH 128
-typedef __m128i vec16_t;
-typedef __m128i vec8_t;
-typedef uint16_t mask_t;
-#define vec_add_16(a,b) _mm_add_epi16(a,b)
-#define vec_sub_16(a,b) _mm_sub_epi16(a,b)
-#define vec_packs(a,b) _mm_packs_epi16(a,b)
-#define vec_mask_pos(a) _mm_movemask_epi8(_mm_cmpgt_epi8(a,_mm_setzero_si128()))
-#ifdef IS_64BIT
-#define NUM_REGS 16
-#else
-#define NUM_REGS 8
-#endif
-
-#elif USE_MMX
-#define SIMD_WIDTH 64
-typedef __m64 vec16_t;
-typedef __m64 vec8_t;
-typedef uint8_t mask_t;
-#define vec_add_16(a,b) _mm_add_pi16(a,b)
-#define vec_sub_16(a,b) _mm_sub_pi16(a,b)
-#define vec_packs(a,b) _mm_packs_pi16(a,b)
-#define vec_mask_pos(a) _mm_movemask_pi8(_mm_cmpgt_pi8(a,_mm_setzero_si64()))
-#define NUM_REGS 8
-
-#elif USE_NEON
-#define SIMD_WIDTH 128
-typedef int16x8_t vec16_t;
-typedef int8x16_t vec8_t;
-typedef uint16_t mask_t;
-#define vec_add_16(a,b) vaddq_s16(a,b)
-#define vec_sub_16(a,b) vsubq_s16(a,b)
-#define vec_packs(a,b) vcombine_s8(vqmovn_s16(a),vqmovn_s16(b))
-#define vec_mask_pos(a) neon_movemask(vcgtq_s8(a,vdupq_n_u8(0)))
-#ifdef IS_64BIT
-#define NUM_REGS 16
-#else
-#define NUM_REGS 8
-#endif
+// Input feature converter, shared by all kernels.
+// The weights are split in one block of PS_END features per (oriented) king
+// square. A full net keeps all 64 blocks in ft_weights: either a copy, or
+// for a mapped net (see nnue_write_mapped()) the read-only file mapping or
+// the embedded net itself. A compact net (see nnue_write_compact()) stays
+// mapped read-only and holds one block per king bucket as a base shared by
+// every bucket plus int8 residuals; blocks are decoded on demand into a
+// small LRU cache so only a bounded part of the transformer is resident.
+static int16_t ft_biases alignas(64) [kHalfDimensions];
+static const int16_t *ft_weights; // full net, NULL in compact mode
+static int16_t *ft_copy;          // ft_weights when not used in place
 
-#else
-#undef VECTOR
-#define SIMD_WIDTH 16 // dummy
-typedef uint8_t mask_t; // dummy
+// Mapped net used in place
+static struct {
+  const void *data;                     // net in use, NULL if copied
+  map_t mapping;                        // 0 for the embedded net
+} mapped;
 
-#endif
+enum {
+  BlockSize = kHalfDimensions * PS_END, // int16 per king block
+  CompactMagic = 0x54474331,            // "TGC1"
+  CompactHeader = 4 + 4 + 64,
+  CompactRow = 4 + kHalfDimensions      // u32 scale + int8 residuals
+};
 
-#ifdef IS_64BIT
-typedef uint64_t mask2_t;
-#else
-typedef uint32_t mask2_t;
-#endif
+static struct {
+  const char *data;                     // mapped compact net, NULL if none
+  map_t mapping;
+  unsigned buckets;
+  const uint8_t *bucketOf;              // oriented king square -> bucket
+  const char *base;                     // int16 [PS_END][256]
+  const char *rows;                     // [buckets][PS_END] CompactRow
+} compact;
+
+// Decoded block cache (compact mode only). Each thread has its own, so that
+// lookups and decodes take no lock; a thread only pins the two blocks of the
+// accumulator it is building. The slots are (re)allocated by their thread on
+// its next use once the net or the budget changed (blockEpoch).
+typedef struct {
+  int16_t *weights;
+  int bucket;                           // -1 if empty
+  uint64_t lastUse;
+} BlockSlot;
+
+static void free_aligned64(void *aligned);
+
+struct BlockCache {
+  BlockSlot *slots;
+  unsigned slotNb;
+  unsigned epoch;                       // blockEpoch the slots belong to
+  uint64_t clock, hits;                 // hits not yet in nnue_block_stats
+
+  void release() {
+    for (unsigned i = 0; i < slotNb; i++)
+      free_aligned64(slots[i].weights);
+    free(slots);
+    slots = NULL;
+    slotNb = 0;
+  }
+  ~BlockCache() { release(); }
+};
 
-typedef int8_t clipped_t;
-#if defined(USE_MMX) || (defined(USE_SSE2) && !defined(USE_AVX2))
-typedef int16_t weight_t;
-#else
-typedef int8_t weight_t;
-#endif
+static thread_local BlockCache blockCache;
+static std::atomic<unsigned> blockEpoch(1);
+static unsigned blockSlotNb;            // slots per thread for the current net
+static size_t blockCacheBytes = 8 * 1024 * 1024;
 
-typedef struct {
-  size_t size;
-  unsigned values[30];
-} IndexList;
+// Totals of all threads, flushed by each thread on its misses
+static struct {
+  std::atomic<uint64_t> hits, misses;
+} nnue_block_stats;
 
-INLINE int orient(int c, int s)
+static void *alloc_aligned64(size_t size)
 {
-  return s ^ (c == white ? 0x00 : 0x3f);
+  void *ptr = malloc(size + 64);
+  if (!ptr) return NULL;
+  void *aligned = (void *)(((uintptr_t)ptr + 64) & ~(uintptr_t)63);
+  ((void **)aligned)[-1] = ptr;
+  return aligned;
 }
 
-INLINE unsigned make_index(int c, int s, int pc, int ksq)
+static void free_aligned64(void *aligned)
 {
-  return orient(c, s) + PieceToIndex[c][pc] + PS_END * ksq;
+  if (aligned) free(((void **)aligned)[-1]);
 }
 
-static void half_kp_append_active_indices(const Position *pos, const int c,
-    IndexList *active)
+static void decode_block(int16_t *weights, unsigned bucket)
 {
-  int ksq = pos->squares[c];
-  ksq = orient(c, ksq);
-  for (int i = 2; pos->pieces[i]; i++) {
-    int sq = pos->squares[i];
-    int pc = pos->pieces[i];
-    active->values[active->size++] = make_index(c, sq, pc, ksq);
-  }
-}
+  const char *base = compact.base;
+  const char *row = compact.rows + (size_t)bucket * PS_END * CompactRow;
 
-static void half_kp_append_changed_indices(const Position *pos, const int c,
-    const DirtyPiece *dp, IndexList *removed, IndexList *added)
-{
-  int ksq = pos->squares[c];
-  ksq = orient(c, ksq);
-  for (int i = 0; i < dp->dirtyNum; i++) {
-    int pc = dp->pc[i];
-    if (IS_KING(pc)) continue;
-    if (dp->from[i] != 64)
-      removed->values[removed->size++] = make_index(c, dp->from[i], pc, ksq);
-    if (dp->to[i] != 64)
-      added->values[added->size++] = make_index(c, dp->to[i], pc, ksq);
+  for (unsigned i = 0; i < PS_END; i++, row += CompactRow) {
+    int32_t scale = (int32_t)readu_le_u32(row);
+    const int8_t *q = (const int8_t *)(row + 4);
+    for (unsigned j = 0; j < kHalfDimensions; j++, base += 2)
+      weights[i * kHalfDimensions + j] =
+          (int16_t)readu_le_u16(base) + ((q[j] * scale + 128) >> 8);
   }
 }
 
-static void append_active_indices(const Position *pos, IndexList active[2])
+// Size the per-thread caches for the current net and budget; the threads
+// drop their old slots on their next use
+static void block_cache_reset()
 {
-  for (unsigned c = 0; c < 2; c++)
-    half_kp_append_active_indices(pos, c, &active[c]);
+  unsigned nb = (unsigned)(blockCacheBytes / (BlockSize * sizeof(int16_t)));
+  if (nb < 2) nb = 2; // both perspectives must fit
+  if (nb > compact.buckets) nb = compact.buckets > 2 ? compact.buckets : 2;
+
+  blockSlotNb = nb;
+  blockEpoch++;
+  nnue_block_stats.hits = 0;
+  nnue_block_stats.misses = 0;
 }
 
-static void append_changed_indices(const Position *pos, IndexList removed[2],
-    IndexList added[2], bool reset[2])
+static bool block_cache_alloc(BlockCache *cache)
 {
-  const DirtyPiece *dp = &(pos->nnue[0]->dirtyPiece);
-  // assert(dp->dirtyNum != 0);
-
-  if (pos->nnue[1]->accumulator.computedAccumulation) {
-    for (unsigned c = 0; c < 2; c++) {
-      reset[c] = dp->pc[0] == (int)KING(c);
-      if (reset[c])
-        half_kp_append_active_indices(pos, c, &added[c]);
-      else
-        half_kp_append_changed_indices(pos, c, dp, &removed[c], &added[c]);
-    }
-  } else {
-    const DirtyPiece *dp2 = &(pos->nnue[1]->dirtyPiece);
-    for (unsigned c = 0; c < 2; c++) {
-      reset[c] =   dp->pc[0] == (int)KING(c)
-                || dp2->pc[0] == (int)KING(c);
-      if (reset[c])
-        half_kp_append_active_indices(pos, c, &added[c]);
-      else {
-        half_kp_append_changed_indices(pos, c, dp, &removed[c], &added[c]);
-        half_kp_append_changed_indices(pos, c, dp2, &removed[c], &added[c]);
-      }
+  cache->release();
+  cache->epoch = blockEpoch;
+  cache->slots = (BlockSlot *)calloc(blockSlotNb, sizeof(BlockSlot));
+  if (!cache->slots) return false;
+  cache->slotNb = blockSlotNb;
+  for (unsigned i = 0; i < cache->slotNb; i++) {
+    cache->slots[i].bucket = -1;
+    cache->slots[i].weights = (int16_t *)alloc_aligned64(BlockSize * sizeof(int16_t));
+    if (!cache->slots[i].weights) {
+      cache->release();
+      return false;
     }
   }
+  cache->hits = 0;
+  return true;
 }
 
-// InputLayer = InputSlice<256 * 2>
-// out: 512 x clipped_t
-
-// Hidden1Layer = ClippedReLu<AffineTransform<InputLayer, 32>>
-// 512 x clipped_t -> 32 x int32_t -> 32 x clipped_t
+// Slot of the calling thread holding the bucket, decoding it into the least
+// recently used slot other than the pinned one on a miss
+static int block_find(BlockCache *cache, int bucket, int pinned)
+{
+  int victim = -1;
 
-// Hidden2Layer = ClippedReLu<AffineTransform<hidden1, 32>>
-// 32 x clipped_t -> 32 x int32_t -> 32 x clipped_t
+  for (unsigned i = 0; i < cache->slotNb; i++) {
+    BlockSlot *slot = &cache->slots[i];
+    if (slot->bucket == bucket) {
+      cache->hits++;
+      slot->lastUse = ++cache->clock;
+      return i;
+    }
+    if ((int)i != pinned && (victim < 0 || slot->lastUse < cache->slots[victim].lastUse))
+      victim = i;
+  }
 
-// OutputLayer = AffineTransform<HiddenLayer2, 1>
-// 32 x clipped_t -> 1 x int32_t
+  BlockSlot *slot = &cache->slots[victim];
+  decode_block(slot->weights, bucket);
+  slot->bucket = bucket;
+  slot->lastUse = ++cache->clock;
 
-#if !defined(USE_AVX512)
-static weight_t hidden1_weights alignas(64) [32 * 512];
-static weight_t hidden2_weights alignas(64) [32 * 32];
-#else
-static weight_t hidden1_weights alignas(64) [64 * 512];
-static weight_t hidden2_weights alignas(64) [64 * 32];
-#endif
-static weight_t output_weights alignas(64) [1 * 32];
+  nnue_block_stats.hits += cache->hits;
+  nnue_block_stats.misses++;
+  cache->hits = 0;
 
-static int32_t hidden1_biases alignas(64) [32];
-static int32_t hidden2_biases alignas(64) [32];
-static int32_t output_biases[1];
+  return victim;
+}
 
-INLINE int32_t affine_propagate(clipped_t *input, int32_t *biases,
-    weight_t *weights)
+// King blocks of both perspectives for an accumulator refresh or update
+static void ft_acquire(const Position *pos, const int16_t *columns[2])
 {
-#if defined(USE_AVX2)
-  __m256i *iv = (__m256i *)input;
-  __m256i *row = (__m256i *)weights;
-#if defined(USE_VNNI)
-  __m256i prod = _mm256_dpbusd_epi32(_mm256_setzero_si256(), iv[0], row[0]);
-#else
-  __m256i prod = _mm256_maddubs_epi16(iv[0], row[0]);
-  prod = _mm256_madd_epi16(prod, _mm256_set1_epi16(1));
-#endif
-  __m128i sum = _mm_add_epi32(
-      _mm256_castsi256_si128(prod), _mm256_extracti128_si256(prod, 1));
-  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x1b));
-  return _mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 1) + biases[0];
+  int ksq[2];
+  ksq[0] = pos->squares[0];
+  ksq[1] = pos->squares[1] ^ 0x3f;
 
-#elif defined(USE_SSE2)
-  __m128i *iv = (__m128i *)input;
-  __m128i *row = (__m128i *)weights;
-#if defined(AVOID_USE_SSSE3)
-  const __m128i kOnes = _mm_set1_epi16(1);
-  __m128i p0 = _mm_madd_epi16(_mm_maddubs_epi16(iv[0], row[0]), kOnes);
-  __m128i p1 = _mm_madd_epi16(_mm_maddubs_epi16(iv[1], row[1]), kOnes);
-  __m128i sum = _mm_add_epi32(p0, p1);
-#else
-  __m128i p0 = _mm_madd_epi16(iv[0], row[0]);
-  __m128i p1 = _mm_madd_epi16(iv[1], row[1]);
-  __m128i p2 = _mm_madd_epi16(iv[2], row[2]);
-  __m128i p3 = _mm_madd_epi16(iv[3], row[3]);
-  __m128i sum = _mm_add_epi32(_mm_add_epi32(p0, p1), _mm_add_epi32(p2, p3));
-#endif
-  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb));
-#if defined(USE_SSE41)
-  return _mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 1) + biases[0];
-#else
-  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x1));
-  return _mm_cvtsi128_si32(sum) + biases[0];
-#endif
+  if (!compact.data) {
+    for (int c = 0; c < 2; c++)
+      columns[c] = &ft_weights[(size_t)BlockSize * ksq[c]];
+    return;
+  }
 
-#elif defined(USE_MMX)
-  __m64 *iv = (__m64 *)input;
-  __m64 s0 = _mm_setzero_si64(), s1 = s0;
-  __m64 *row = (__m64 *)weights;
-  for (unsigned j = 0; j < 4; j++) {
-    s0 = _mm_add_pi32(s0, _mm_madd_pi16(row[2 * j], iv[2 * j]));
-    s1 = _mm_add_pi32(s1, _mm_madd_pi16(row[2 * j + 1], iv[2 * j + 1]));
+  BlockCache *cache = &blockCache;
+  if (cache->epoch != blockEpoch && !block_cache_alloc(cache)) {
+    fprintf(stderr, "NNUE: cannot allocate the decoded block cache\n");
+    exit(EXIT_FAILURE);
   }
-  __m64 sum = _mm_add_pi32(s0, s1);
-  sum = _mm_add_pi32(sum, _mm_unpackhi_pi32(sum, sum));
-  return _mm_cvtsi64_si32(sum) + biases[0];
 
-#elif defined(USE_NEON)
-  int8x8_t *iv = (int8x8_t *)input;
-  int32x4_t sum = {biases[0]};
-  int8x8_t *row = (int8x8_t *)weights;
-  int16x8_t p0 = vmull_s8(iv[0], row[0]);
-  int16x8_t p1 = vmull_s8(iv[1], row[1]);
-  p0 = vmlal_s8(p0, iv[2], row[2]);
-  sum = vpadalq_s16(sum, p0);
-  p1 = vmlal_s8(p1, iv[3], row[3]);
-  sum = vpadalq_s16(sum, p1);
-  return sum[0] + sum[1] + sum[2] + sum[3];
+  int slot0 = block_find(cache, compact.bucketOf[ksq[0]], -1);
+  int slot1 = block_find(cache, compact.bucketOf[ksq[1]], slot0);
+  columns[0] = cache->slots[slot0].weights;
+  columns[1] = cache->slots[slot1].weights;
+}
+
+typedef struct NNUEKernel {
+  const char *name;
+  void (*init_network)(const char *d);
+  int (*evaluate_pos)(Position *pos);
+} NNUEKernel;
+
+#define KERNEL_NAME2(x) #x
+#define KERNEL_NAME(x) KERNEL_NAME2(x)
+
+#if defined(USE_DISPATCH)
+
+// One kernel per x86 instruction set, picked at startup from CPUID.
+// SSSE3 shares the SSE2 code (the int8 SSSE3 path is disabled upstream)
+// but is still built with -mssse3 code generation.
+
+#pragma GCC push_options
+#pragma GCC target("avx512vnni,avx512vl,avx512f,avx512bw,avx2,popcnt,sse4.1,ssse3")
+#define NNUE_KERNEL avx512vnni
+#define USE_VNNI 1
+#define USE_AVX512 1
+#define USE_AVX2 1
+#define USE_SSE41 1
+#define USE_SSSE3 1
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx2,popcnt,sse4.1,ssse3")
+#define NNUE_KERNEL avx512bw
+#define USE_AVX512 1
+#define USE_AVX2 1
+#define USE_SSE41 1
+#define USE_SSSE3 1
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt,sse4.1,ssse3")
+#define NNUE_KERNEL avx2
+#define USE_AVX2 1
+#define USE_SSE41 1
+#define USE_SSSE3 1
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("sse4.1,ssse3")
+#define NNUE_KERNEL sse41
+#define USE_SSE41 1
+#define USE_SSSE3 1
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#define NNUE_KERNEL ssse3
+#define USE_SSSE3 1
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define NNUE_KERNEL sse2
+#define USE_SSE2 1
+#define USE_SSE 1
+#include "nnue_kernel.h"
+#pragma GCC pop_options
+
+#define NNUE_KERNEL scalar
+#include "nnue_kernel.h"
+
+static const NNUEKernel *Kernels[] = {
+  &avx512vnni::kernel, &avx512bw::kernel, &avx2::kernel, &sse41::kernel,
+  &ssse3::kernel, &sse2::kernel, &scalar::kernel
+};
+
+static bool kernel_supported(unsigned i)
+{
+  __builtin_cpu_init();
+  switch (i) {
+    case 0: return __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vl")
+                && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx2");
+    case 1: return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx2");
+    case 2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case 3: return __builtin_cpu_supports("sse4.1");
+    case 4: return __builtin_cpu_supports("ssse3");
+    case 5: return __builtin_cpu_supports("sse2");
+    default: return true;
+  }
+}
 
 #else
-  int32_t sum = biases[0];
-  for (unsigned j = 0; j < 32; j++)
-    sum += weights[j] * input[j];
-  return sum;
 
-#endif
-}
+// Single kernel selected at compile time by the USE_* flags
+
+#define NNUE_KERNEL native
+#include "nnue_kernel.h"
 
-static_assert(FtOutDims % 64 == 0, "FtOutDims not a multiple of 64");
+static const NNUEKernel *Kernels[] = { &native::kernel };
 
-#ifdef VECTOR
-INLINE bool next_idx(unsigned *idx, unsigned *offset, mask2_t *v,
-    mask_t *mask, unsigned inDims)
+static bool kernel_supported(unsigned i)
 {
-  while (*v == 0) {
-    *offset += 8 * sizeof(mask2_t);
-    if (*offset >= inDims) return false;
-    memcpy(v, (char *)mask + (*offset / 8), sizeof(mask2_t));
-  }
-#ifdef IS_64BIT
-  *idx = *offset + bsf(*v);
-#else
-  *idx = *offset + bsf(*v);
-#endif
-  *v &= *v - 1;
+  (void)i;
   return true;
 }
 
-#if defined(USE_MMX) && !defined(USE_SSE)
-INLINE int _mm_movemask_pi8(__m64 v)
-{
-  const __m64 powers = _mm_set_pi8(-128, 64, 32, 16, 8, 4, 2, 1);
-  __m64 m = _mm_and_si64(v, powers);
-  m = _mm_or_si64(m, _mm_srli_si64(m, 32));
-  m = _mm_or_si64(m, _mm_srli_pi32(m, 16));
-  m = _mm_or_si64(m, _mm_srli_pi16(m, 8));
-  return _mm_cvtsi64_si32(m) & 0xff;
-}
-#elif defined(USE_NEON)
-INLINE int neon_movemask(uint8x16_t v)
+#endif
+
+enum { KernelNb = sizeof(Kernels) / sizeof(Kernels[0]) };
+
+static const NNUEKernel *kernel;
+
+// Kernels are listed from the fastest to the slowest
+static unsigned best_kernel()
 {
-  const uint8_t __attribute__((aligned(16))) powers[16] =
-    { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
-  const uint8x16_t kPowers = vld1q_u8(powers);
+  for (unsigned i = 0; i < KernelNb; i++)
+    if (kernel_supported(i))
+      return i;
 
-  uint64x2_t mask = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(v, kPowers))));
-  return   vgetq_lane_u8((uint8x16_t)mask, 0)
-        | (vgetq_lane_u8((uint8x16_t)mask, 8) << 8);
+  return KernelNb - 1;
 }
-#endif
-#endif
 
-#if defined(USE_AVX512)
-INLINE void affine_txfm(int8_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
-{
-  assert(outDims == 32);
-
-  (void)outDims;
-  const __m512i kZero = _mm512_setzero_si512();
-  __m512i out_0 = ((__m512i *)biases)[0];
-  __m512i out_1 = ((__m512i *)biases)[1];
-  __m512i first, second;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = ((__m512i *)weights)[idx];
-    uint16_t factor = input[idx];
-    if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-      second = ((__m512i *)weights)[idx];
-      factor |= input[idx] << 8;
-    } else {
-      second = kZero;
-    }
-    __m512i mul = _mm512_set1_epi16(factor), prod, signs;
-    prod = _mm512_maddubs_epi16(mul, _mm512_unpacklo_epi8(first, second));
-    signs = _mm512_srai_epi16(prod, 15);
-    out_0 = _mm512_add_epi32(out_0, _mm512_unpacklo_epi16(prod, signs));
-    out_1 = _mm512_add_epi32(out_1, _mm512_unpackhi_epi16(prod, signs));
-  }
+enum {
+  TransformerStart = 3 * 4 + 177,
+  NetworkStart = TransformerStart + 4 + 2 * 256 + 2 * 256 * 64 * 641,
+  NetSize = 21022697
+};
 
-  __m512i out16 = _mm512_srai_epi16(_mm512_packs_epi32(out_0, out_1), SHIFT);
+// Mapped net: the standard net with the 189 byte header replaced by a 64
+// byte one, so that the transformer (int16, little-endian) starts on a
+// cache line and can be used by the SIMD kernels straight from the mapping.
+enum {
+  MappedMagic = 0x54474d31,             // "TGM1"
+  MappedHeader = 64,
+  TransformerSize = NetworkStart - TransformerStart - 4,
+  MappedSize = MappedHeader + NetSize - TransformerStart - 4
+};
 
-  __m256i *outVec = (__m256i *)output;
-  const __m256i kZero256 = _mm256_setzero_si256();
-  outVec[0] = _mm256_packs_epi16(
-      _mm512_castsi512_si256(out16),_mm512_extracti64x4_epi64(out16, 1));
-  if (pack8_and_calc_mask)
-    outMask[0] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(outVec[0], kZero256));
-  else
-    outVec[0] = _mm256_max_epi8(outVec[0], kZero256);
-}
-#elif defined(USE_AVX2)
-INLINE void affine_txfm(int8_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
+static bool verify_net(const void *evalData, size_t size)
 {
-  assert(outDims == 32);
-
-  (void)outDims;
-  const __m256i kZero = _mm256_setzero_si256();
-  __m256i out_0 = ((__m256i *)biases)[0];
-  __m256i out_1 = ((__m256i *)biases)[1];
-  __m256i out_2 = ((__m256i *)biases)[2];
-  __m256i out_3 = ((__m256i *)biases)[3];
-  __m256i first, second;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = ((__m256i *)weights)[idx];
-    uint16_t factor = input[idx];
-    if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-      second = ((__m256i *)weights)[idx];
-      factor |= input[idx] << 8;
-    } else {
-      second = kZero;
-    }
-    __m256i mul = _mm256_set1_epi16(factor), prod, signs;
-    prod = _mm256_maddubs_epi16(mul, _mm256_unpacklo_epi8(first, second));
-    signs = _mm256_cmpgt_epi16(kZero, prod);
-    out_0 = _mm256_add_epi32(out_0, _mm256_unpacklo_epi16(prod, signs));
-    out_1 = _mm256_add_epi32(out_1, _mm256_unpackhi_epi16(prod, signs));
-    prod = _mm256_maddubs_epi16(mul, _mm256_unpackhi_epi8(first, second));
-    signs = _mm256_cmpgt_epi16(kZero, prod);
-    out_2 = _mm256_add_epi32(out_2, _mm256_unpacklo_epi16(prod, signs));
-    out_3 = _mm256_add_epi32(out_3, _mm256_unpackhi_epi16(prod, signs));
-  }
+  if (size != NetSize) return false;
 
-  __m256i out16_0 = _mm256_srai_epi16(_mm256_packs_epi32(out_0, out_1), SHIFT);
-  __m256i out16_1 = _mm256_srai_epi16(_mm256_packs_epi32(out_2, out_3), SHIFT);
+  const char *d = (const char*)evalData;
+  if (readu_le_u32(d) != NnueVersion) return false;
+  if (readu_le_u32(d + 4) != 0x3e5aa6eeU) return false;
+  if (readu_le_u32(d + 8) != 177) return false;
+  if (readu_le_u32(d + TransformerStart) != 0x5d69d7b8) return false;
+  if (readu_le_u32(d + NetworkStart) != 0x63337156) return false;
 
-  __m256i *outVec = (__m256i *)output;
-  outVec[0] = _mm256_packs_epi16(out16_0, out16_1);
-  if (pack8_and_calc_mask)
-    outMask[0] = _mm256_movemask_epi8(_mm256_cmpgt_epi8(outVec[0], kZero));
-  else
-    outVec[0] = _mm256_max_epi8(outVec[0], kZero);
+  return true;
 }
-#elif AVOID_USE_SSSE3
-INLINE void affine_txfm(int8_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
-{
-  assert(outDims == 32);
-
-  const __m128i kZeros[2] = { 0 };
-  __m128i out_0 = ((__m128i *)biases)[0];
-  __m128i out_1 = ((__m128i *)biases)[1];
-  __m128i out_2 = ((__m128i *)biases)[2];
-  __m128i out_3 = ((__m128i *)biases)[3];
-  __m128i out_4 = ((__m128i *)biases)[4];
-  __m128i out_5 = ((__m128i *)biases)[5];
-  __m128i out_6 = ((__m128i *)biases)[6];
-  __m128i out_7 = ((__m128i *)biases)[7];
-  const __m128i *first, *second;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = (__m128i *)&weights[outDims * idx];
-    uint16_t factor = input[idx];
-    if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-      second = (__m128i *)&weights[outDims * idx];
-      factor |= input[idx] << 8;
-    } else {
-      second = kZeros;
-    }
-    __m128i mul = _mm_set1_epi16(factor), prod, signs;
-    prod = _mm_maddubs_epi16(mul, _mm_unpacklo_epi8(first[0], second[0]));
-    signs = _mm_cmpgt_epi16(kZeros[0], prod);
-    out_0 = _mm_add_epi32(out_0, _mm_unpacklo_epi16(prod, signs));
-    out_1 = _mm_add_epi32(out_1, _mm_unpackhi_epi16(prod, signs));
-    prod = _mm_maddubs_epi16(mul, _mm_unpackhi_epi8(first[0], second[0]));
-    signs = _mm_cmpgt_epi16(kZeros[0], prod);
-    out_2 = _mm_add_epi32(out_2, _mm_unpacklo_epi16(prod, signs));
-    out_3 = _mm_add_epi32(out_3, _mm_unpackhi_epi16(prod, signs));
-    prod = _mm_maddubs_epi16(mul, _mm_unpacklo_epi8(first[1], second[1]));
-    signs = _mm_cmpgt_epi16(kZeros[0], prod);
-    out_4 = _mm_add_epi32(out_4, _mm_unpacklo_epi16(prod, signs));
-    out_5 = _mm_add_epi32(out_5, _mm_unpackhi_epi16(prod, signs));
-    prod = _mm_maddubs_epi16(mul, _mm_unpackhi_epi8(first[1], second[1]));
-    signs = _mm_cmpgt_epi16(kZeros[0], prod);
-    out_6 = _mm_add_epi32(out_6, _mm_unpacklo_epi16(prod, signs));
-    out_7 = _mm_add_epi32(out_7, _mm_unpackhi_epi16(prod, signs));
-  }
 
-  __m128i out16_0 = _mm_srai_epi16(_mm_packs_epi32(out_0, out_1), SHIFT);
-  __m128i out16_1 = _mm_srai_epi16(_mm_packs_epi32(out_2, out_3), SHIFT);
-  __m128i out16_2 = _mm_srai_epi16(_mm_packs_epi32(out_4, out_5), SHIFT);
-  __m128i out16_3 = _mm_srai_epi16(_mm_packs_epi32(out_6, out_7), SHIFT);
-
-  __m128i *outVec = (__m128i *)output;
-  if (pack8_and_calc_mask) {
-    outVec[0] = _mm_packs_epi16(out16_0, out16_1);
-    outMask[0] = _mm_movemask_epi8(_mm_cmpgt_epi8(outVec[0], kZeros[0]));
-    outVec[1] = _mm_packs_epi16(out16_2, out16_3);
-    outMask[1] = _mm_movemask_epi8(_mm_cmpgt_epi8(outVec[1], kZeros[0]));
-  } else {
-#if defined(USE_SSE41)
-    outVec[0] = _mm_max_epi8(_mm_packs_epi16(out16_0, out16_1), kZeros[0]);
-    outVec[1] = _mm_max_epi8(_mm_packs_epi16(out16_2, out16_3), kZeros[0]);
-#else
-    outVec[0] = _mm_packs_epi16(
-        _mm_max_epi16(out16_0, kZeros[0]), _mm_max_epi16(out16_1, kZeros[0]));
-    outVec[1] = _mm_packs_epi16(
-        _mm_max_epi16(out16_2, kZeros[0]), _mm_max_epi16(out16_3, kZeros[0]));
-#endif
-  }
-}
-#elif defined(USE_SSE2)
-INLINE void affine_txfm(clipped_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
+static bool verify_mapped(const void *evalData, size_t size)
 {
-  assert(outDims == 32);
-
-  const __m128i kZeros[4] = { 0 };
-  __m128i out_0 = ((__m128i *)biases)[0];
-  __m128i out_1 = ((__m128i *)biases)[1];
-  __m128i out_2 = ((__m128i *)biases)[2];
-  __m128i out_3 = ((__m128i *)biases)[3];
-  __m128i out_4 = ((__m128i *)biases)[4];
-  __m128i out_5 = ((__m128i *)biases)[5];
-  __m128i out_6 = ((__m128i *)biases)[6];
-  __m128i out_7 = ((__m128i *)biases)[7];
-  const __m128i *first, *second;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = (__m128i *)&weights[outDims * idx];
-    uint32_t factor = input[idx];
-    if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-      second = (__m128i *)&weights[outDims * idx];
-      factor |= input[idx] << 16;
-    } else {
-      second = kZeros;
-    }
-    __m128i mul = _mm_set1_epi32(factor);
-    out_0 = _mm_add_epi32(out_0, _mm_madd_epi16(mul, _mm_unpacklo_epi16(first[0],second[0])));
-    out_1 = _mm_add_epi32(out_1, _mm_madd_epi16(mul, _mm_unpackhi_epi16(first[0],second[0])));
-    out_2 = _mm_add_epi32(out_2, _mm_madd_epi16(mul, _mm_unpacklo_epi16(first[1],second[1])));
-    out_3 = _mm_add_epi32(out_3, _mm_madd_epi16(mul, _mm_unpackhi_epi16(first[1],second[1])));
-    out_4 = _mm_add_epi32(out_4, _mm_madd_epi16(mul, _mm_unpacklo_epi16(first[2],second[2])));
-    out_5 = _mm_add_epi32(out_5, _mm_madd_epi16(mul, _mm_unpackhi_epi16(first[2],second[2])));
-    out_6 = _mm_add_epi32(out_6, _mm_madd_epi16(mul, _mm_unpacklo_epi16(first[3],second[3])));
-    out_7 = _mm_add_epi32(out_7, _mm_madd_epi16(mul, _mm_unpackhi_epi16(first[3],second[3])));
-  }
+  if (size != MappedSize) return false;
 
-  __m128i out16_0 = _mm_srai_epi16(_mm_packs_epi32(out_0, out_1), SHIFT);
-  __m128i out16_1 = _mm_srai_epi16(_mm_packs_epi32(out_2, out_3), SHIFT);
-  __m128i out16_2 = _mm_srai_epi16(_mm_packs_epi32(out_4, out_5), SHIFT);
-  __m128i out16_3 = _mm_srai_epi16(_mm_packs_epi32(out_6, out_7), SHIFT);
-
-  __m128i *outVec = (__m128i *)output;
-  if (pack8_and_calc_mask) {
-    outVec[0] = _mm_packs_epi16(out16_0, out16_1);
-    outMask[0] = _mm_movemask_epi8(_mm_cmpgt_epi8(outVec[0], kZeros[0]));
-    outVec[1] = _mm_packs_epi16(out16_2, out16_3);
-    outMask[1] = _mm_movemask_epi8(_mm_cmpgt_epi8(outVec[1], kZeros[0]));
-  } else {
-    const __m128i kx07f = _mm_set1_epi16(127);
-    outVec[0] = _mm_min_epi16(_mm_max_epi16(out16_0, kZeros[0]), kx07f);
-    outVec[1] = _mm_min_epi16(_mm_max_epi16(out16_1, kZeros[0]), kx07f);
-    outVec[2] = _mm_min_epi16(_mm_max_epi16(out16_2, kZeros[0]), kx07f);
-    outVec[3] = _mm_min_epi16(_mm_max_epi16(out16_3, kZeros[0]), kx07f);
-  }
+  const char *d = (const char*)evalData;
+  if (readu_le_u32(d) != MappedMagic) return false;
+  if (readu_le_u32(d + 4) != NnueVersion) return false;
+  if (readu_le_u32(d + MappedHeader + TransformerSize) != 0x63337156) return false;
+
+  return true;
 }
-#elif defined(USE_MMX)
-INLINE void affine_txfm(clipped_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
-{
-  assert(outDims == 32);
-
-#if 0
-  const __m64 kZeros[2] = { 0 };
-  for (unsigned t = 0; t < 4; t++) {
-    __m64 out_0 = ((__m64 *)biases)[4 * t + 0];
-    __m64 out_1 = ((__m64 *)biases)[4 * t + 1];
-    __m64 out_2 = ((__m64 *)biases)[4 * t + 2];
-    __m64 out_3 = ((__m64 *)biases)[4 * t + 3];
-    const __m64 *first, *second;
-    mask2_t v;
-    unsigned idx;
-
-    memcpy(&v, inMask, sizeof(mask2_t));
-    for (unsigned offset = 0; offset < inDims;) {
-      if (!next_idx(&idx, &offset, &v, inMask, inDims))
-        break;
-      first = &((__m64 *)&weights[outDims * idx])[2  * t];
-      uint32_t factor = input[idx];
-      if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-        second = &((__m64 *)&weights[outDims * idx])[2 * t];
-        factor |= input[idx] << 16;
-      } else {
-        second = kZeros;
-      }
-      __m64 mul = _mm_set1_pi32(factor);
-      out_0 = _mm_add_pi32(out_0, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[0],second[0])));
-      out_1 = _mm_add_pi32(out_1, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[0],second[0])));
-      out_2 = _mm_add_pi32(out_2, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[1],second[1])));
-      out_3 = _mm_add_pi32(out_3, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[1],second[1])));
-    }
 
-    __m64 out16_0 = _mm_srai_pi16(_mm_packs_pi32(out_0, out_1), SHIFT);
-    __m64 out16_1 = _mm_srai_pi16(_mm_packs_pi32(out_2, out_3), SHIFT);
-
-    __m64 *outVec = (__m64 *)output;
-    if (pack8_and_calc_mask) {
-      outVec[t] = _mm_packs_pi16(out16_0, out16_1);
-      outMask[t] = _mm_movemask_pi8(_mm_cmpgt_pi8(outVec[t], kZeros[0]));
-    } else {
-#ifdef USE_SSE
-      const __m64 kx07f = _mm_set1_pi16(127);
-      outVec[2 * t] = _mm_min_pi16(_mm_max_pi16(out16_0, kZeros[0]), kx07f);
-      outVec[2 * t + 1] = _mm_min_pi16(_mm_max_pi16(out16_1, kZeros[0]), kx07f);
-#else
-      const __m64 k0x7f80 = _mm_set1_pi16(0x7f80);
-      const __m64 k0x0080 = _mm_set1_pi16(0x0080);
-      const __m64 k0x8000 = _mm_set1_pi16(-0x8000);
-      outVec[2 * t] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_0, k0x7f80), k0x0080), k0x8000);
-      outVec[2 * t + 1] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_1, k0x7f80), k0x0080), k0x8000);
-#endif
-    }
-  }
-#else
-  const __m64 kZeros[8] = { 0 };
-  __m64 out_0 = ((__m64 *)biases)[0];
-  __m64 out_1 = ((__m64 *)biases)[1];
-  __m64 out_2 = ((__m64 *)biases)[2];
-  __m64 out_3 = ((__m64 *)biases)[3];
-  __m64 out_4 = ((__m64 *)biases)[4];
-  __m64 out_5 = ((__m64 *)biases)[5];
-  __m64 out_6 = ((__m64 *)biases)[6];
-  __m64 out_7 = ((__m64 *)biases)[7];
-  __m64 out_8 = ((__m64 *)biases)[8];
-  __m64 out_9 = ((__m64 *)biases)[9];
-  __m64 out_10 = ((__m64 *)biases)[10];
-  __m64 out_11 = ((__m64 *)biases)[11];
-  __m64 out_12 = ((__m64 *)biases)[12];
-  __m64 out_13 = ((__m64 *)biases)[13];
-  __m64 out_14 = ((__m64 *)biases)[14];
-  __m64 out_15 = ((__m64 *)biases)[15];
-  const __m64 *first, *second;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = (__m64 *)&weights[outDims * idx];
-    uint32_t factor = input[idx];
-    if (next_idx(&idx, &offset, &v, inMask, inDims)) {
-      second = (__m64 *)&weights[outDims * idx];
-      factor |= input[idx] << 16;
-    } else {
-      second = kZeros;
-    }
-    __m64 mul = _mm_set1_pi32(factor);
-    out_0 = _mm_add_pi32(out_0, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[0],second[0])));
-    out_1 = _mm_add_pi32(out_1, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[0],second[0])));
-    out_2 = _mm_add_pi32(out_2, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[1],second[1])));
-    out_3 = _mm_add_pi32(out_3, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[1],second[1])));
-    out_4 = _mm_add_pi32(out_4, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[2],second[2])));
-    out_5 = _mm_add_pi32(out_5, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[2],second[2])));
-    out_6 = _mm_add_pi32(out_6, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[3],second[3])));
-    out_7 = _mm_add_pi32(out_7, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[3],second[3])));
-    out_8 = _mm_add_pi32(out_8, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[4],second[4])));
-    out_9 = _mm_add_pi32(out_9, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[4],second[4])));
-    out_10 = _mm_add_pi32(out_10, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[5],second[5])));
-    out_11 = _mm_add_pi32(out_11, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[5],second[5])));
-    out_12 = _mm_add_pi32(out_12, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[6],second[6])));
-    out_13 = _mm_add_pi32(out_13, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[6],second[6])));
-    out_14 = _mm_add_pi32(out_14, _mm_madd_pi16(mul, _mm_unpacklo_pi16(first[7],second[7])));
-    out_15 = _mm_add_pi32(out_15, _mm_madd_pi16(mul, _mm_unpackhi_pi16(first[7],second[7])));
-  }
+// Transformer biases of a standard or mapped net, followed by the weights,
+// the network hash and the network layers. NULL if neither.
+static const char *net_transformer(const void *evalData)
+{
+  if (verify_net(evalData, NetSize))
+    return (const char *)evalData + TransformerStart + 4;
+  if (verify_mapped(evalData, MappedSize))
+    return (const char *)evalData + MappedHeader;
 
-  __m64 out16_0 = _mm_srai_pi16(_mm_packs_pi32(out_0, out_1), SHIFT);
-  __m64 out16_1 = _mm_srai_pi16(_mm_packs_pi32(out_2, out_3), SHIFT);
-  __m64 out16_2 = _mm_srai_pi16(_mm_packs_pi32(out_4, out_5), SHIFT);
-  __m64 out16_3 = _mm_srai_pi16(_mm_packs_pi32(out_6, out_7), SHIFT);
-  __m64 out16_4 = _mm_srai_pi16(_mm_packs_pi32(out_8, out_9), SHIFT);
-  __m64 out16_5 = _mm_srai_pi16(_mm_packs_pi32(out_10, out_11), SHIFT);
-  __m64 out16_6 = _mm_srai_pi16(_mm_packs_pi32(out_12, out_13), SHIFT);
-  __m64 out16_7 = _mm_srai_pi16(_mm_packs_pi32(out_14, out_15), SHIFT);
-
-  __m64 *outVec = (__m64 *)output;
-  if (pack8_and_calc_mask) {
-    outVec[0] = _mm_packs_pi16(out16_0, out16_1);
-    outMask[0] = _mm_movemask_pi8(_mm_cmpgt_pi8(outVec[0], kZeros[0]));
-    outVec[1] = _mm_packs_pi16(out16_2, out16_3);
-    outMask[1] = _mm_movemask_pi8(_mm_cmpgt_pi8(outVec[1], kZeros[0]));
-    outVec[2] = _mm_packs_pi16(out16_4, out16_5);
-    outMask[2] = _mm_movemask_pi8(_mm_cmpgt_pi8(outVec[2], kZeros[0]));
-    outVec[3] = _mm_packs_pi16(out16_6, out16_7);
-    outMask[3] = _mm_movemask_pi8(_mm_cmpgt_pi8(outVec[3], kZeros[0]));
-  } else {
-#ifdef USE_SSE
-    const __m64 kx07f = _mm_set1_pi16(127);
-    outVec[0] = _mm_min_pi16(_mm_max_pi16(out16_0, kZeros[0]), kx07f);
-    outVec[1] = _mm_min_pi16(_mm_max_pi16(out16_1, kZeros[0]), kx07f);
-    outVec[2] = _mm_min_pi16(_mm_max_pi16(out16_2, kZeros[0]), kx07f);
-    outVec[3] = _mm_min_pi16(_mm_max_pi16(out16_3, kZeros[0]), kx07f);
-    outVec[4] = _mm_min_pi16(_mm_max_pi16(out16_4, kZeros[0]), kx07f);
-    outVec[5] = _mm_min_pi16(_mm_max_pi16(out16_5, kZeros[0]), kx07f);
-    outVec[6] = _mm_min_pi16(_mm_max_pi16(out16_6, kZeros[0]), kx07f);
-    outVec[7] = _mm_min_pi16(_mm_max_pi16(out16_7, kZeros[0]), kx07f);
-#else
-    const __m64 k0x7f80 = _mm_set1_pi16(0x7f80);
-    const __m64 k0x0080 = _mm_set1_pi16(0x0080);
-    const __m64 k0x8000 = _mm_set1_pi16(-0x8000);
-    outVec[0] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_0, k0x7f80), k0x0080), k0x8000);
-    outVec[1] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_1, k0x7f80), k0x0080), k0x8000);
-    outVec[2] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_2, k0x7f80), k0x0080), k0x8000);
-    outVec[3] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_3, k0x7f80), k0x0080), k0x8000);
-    outVec[4] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_4, k0x7f80), k0x0080), k0x8000);
-    outVec[5] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_5, k0x7f80), k0x0080), k0x8000);
-    outVec[6] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_6, k0x7f80), k0x0080), k0x8000);
-    outVec[7] = _mm_subs_pu16(_mm_add_pi16(_mm_adds_pi16(out16_7, k0x7f80), k0x0080), k0x8000);
-#endif
-  }
-#endif
+  return NULL;
 }
-#elif defined(USE_NEON)
-INLINE void affine_txfm(clipped_t *input, void *output, unsigned inDims,
-    unsigned outDims, const int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
-{
-  assert(outDims == 32);
-
-  int32x4_t out_0 = ((int32x4_t *)biases)[0];
-  int32x4_t out_1 = ((int32x4_t *)biases)[1];
-  int32x4_t out_2 = ((int32x4_t *)biases)[2];
-  int32x4_t out_3 = ((int32x4_t *)biases)[3];
-  int32x4_t out_4 = ((int32x4_t *)biases)[4];
-  int32x4_t out_5 = ((int32x4_t *)biases)[5];
-  int32x4_t out_6 = ((int32x4_t *)biases)[6];
-  int32x4_t out_7 = ((int32x4_t *)biases)[7];
-  const int8x8_t *first;
-  mask2_t v;
-  unsigned idx;
-
-  memcpy(&v, inMask, sizeof(mask2_t));
-  for (unsigned offset = 0; offset < inDims;) {
-    if (!next_idx(&idx, &offset, &v, inMask, inDims))
-      break;
-    first = (int8x8_t *)&weights[outDims * idx];
-    int16_t factor = input[idx];
-
-    int16x8_t prod;
-    prod = vmulq_n_s16(vmovl_s8(first[0]), factor);
-    out_0 = vaddq_s32(out_0, vmovl_s16(vget_low_s16(prod)));
-    out_1 = vaddq_s32(out_1, vmovl_high_s16(prod));
-    prod = vmulq_n_s16(vmovl_s8(first[1]), factor);
-    out_2 = vaddq_s32(out_2, vmovl_s16(vget_low_s16(prod)));
-    out_3 = vaddq_s32(out_3, vmovl_high_s16(prod));
-    prod = vmulq_n_s16(vmovl_s8(first[2]), factor);
-    out_4 = vaddq_s32(out_4, vmovl_s16(vget_low_s16(prod)));
-    out_5 = vaddq_s32(out_5, vmovl_high_s16(prod));
-    prod = vmulq_n_s16(vmovl_s8(first[3]), factor);
-    out_6 = vaddq_s32(out_6, vmovl_s16(vget_low_s16(prod)));
-    out_7 = vaddq_s32(out_7, vmovl_high_s16(prod));
-  }
 
-  int16x8_t out16_0 = vcombine_s16(vqshrn_n_s32(out_0, SHIFT), vqshrn_n_s32(out_1, SHIFT));
-  int16x8_t out16_1 = vcombine_s16(vqshrn_n_s32(out_2, SHIFT), vqshrn_n_s32(out_3, SHIFT));
-  int16x8_t out16_2 = vcombine_s16(vqshrn_n_s32(out_4, SHIFT), vqshrn_n_s32(out_5, SHIFT));
-  int16x8_t out16_3 = vcombine_s16(vqshrn_n_s32(out_6, SHIFT), vqshrn_n_s32(out_7, SHIFT));
-
-  if (pack8_and_calc_mask) {
-    const int8x16_t kZero = { 0 };
-    int8x16_t *outVec = (int8x16_t *)output;
-    outVec[0] = vcombine_s8(vqmovn_s16(out16_0), vqmovn_s16(out16_1));
-    outMask[0] = neon_movemask(vcgtq_s8(outVec[0], kZero));
-    outVec[1] = vcombine_s8(vqmovn_s16(out16_2), vqmovn_s16(out16_3));
-    outMask[1] = neon_movemask(vcgtq_s8(outVec[1], kZero));
-  } else {
-    // The next step takes int8x8_t as input, so store as int8x8_t
-    const int8x8_t kZero = { 0 };
-    int8x8_t *outVec = (int8x8_t *)output;
-    outVec[0] = vmax_s8(vqmovn_s16(out16_0), kZero);
-    outVec[1] = vmax_s8(vqmovn_s16(out16_1), kZero);
-    outVec[2] = vmax_s8(vqmovn_s16(out16_2), kZero);
-    outVec[3] = vmax_s8(vqmovn_s16(out16_3), kZero);
-  }
+// The kernels load the transformer with aligned little-endian vectors
+static bool usable_in_place(const char *weights)
+{
+  const uint16_t one = 1;
+  return *(const uint8_t *)&one == 1 && (uintptr_t)weights % 64 == 0;
 }
-#else /* generic fallback */
-INLINE void affine_txfm(clipped_t *input, void *output, unsigned inDims,
-    unsigned outDims, int32_t *biases, const weight_t *weights,
-    mask_t *inMask, mask_t *outMask, const bool pack8_and_calc_mask)
+
+static size_t compact_size(unsigned buckets)
 {
-  (void)inMask; (void)outMask; (void)pack8_and_calc_mask;
+  return CompactHeader + 2 * kHalfDimensions + 2 * (size_t)BlockSize
+       + (size_t)buckets * PS_END * CompactRow + (NetSize - NetworkStart);
+}
 
-  int32_t tmp[outDims];
+static bool verify_compact(const void *evalData, size_t size)
+{
+  const char *d = (const char*)evalData;
+  if (size < CompactHeader) return false;
+  if (readu_le_u32(d) != CompactMagic) return false;
 
-  for (unsigned i = 0; i < outDims; i++)
-    tmp[i] = biases[i];
+  unsigned buckets = readu_le_u32(d + 4);
+  if (buckets < 1 || buckets > 64 || size != compact_size(buckets)) return false;
+  for (unsigned i = 0; i < 64; i++)
+    if ((uint8_t)d[8 + i] >= buckets) return false;
+  if (readu_le_u32(d + size - (NetSize - NetworkStart)) != 0x63337156) return false;
 
-  for (unsigned idx = 0; idx < inDims; idx++)
-    if (input[idx])
-      for (unsigned i = 0; i < outDims; i++)
-        tmp[i] += (int8_t)input[idx] * weights[outDims * idx + i];
+  return true;
+}
 
-  clipped_t *outVec = (clipped_t *)output;
-  for (unsigned i = 0; i < outDims; i++)
-    outVec[i] = clamp(tmp[i] >> SHIFT, 0, 127);
+static void release_weights()
+{
+  if (compact.data) unmap_file(compact.data, compact.mapping);
+  memset(&compact, 0, sizeof(compact));
+  if (mapped.mapping) unmap_file(mapped.data, mapped.mapping);
+  memset(&mapped, 0, sizeof(mapped));
+  free_aligned64(ft_copy);
+  ft_copy = NULL;
+  ft_weights = NULL;
 }
-#endif
 
-// Input feature converter
-static int16_t ft_biases alignas(64) [kHalfDimensions];
-static int16_t ft_weights alignas(64) [kHalfDimensions * FtInDims];
+static void init_kernels(const char *d)
+{
+  // Read network, once for every kernel this host can run
+  for (unsigned i = 0; i < KernelNb; i++)
+    if (kernel_supported(i))
+      Kernels[i]->init_network(d);
 
-#ifdef VECTOR
-#define TILE_HEIGHT (NUM_REGS * SIMD_WIDTH / 16)
-#endif
+  if (!kernel)
+    kernel = Kernels[best_kernel()];
+}
 
-// Calculate cumulative value without using difference calculation
-INLINE void refresh_accumulator(Position *pos)
+DLLExport void _CDECL init_weights(const void *evalData)
 {
-  Accumulator *accumulator = &(pos->nnue[0]->accumulator);
+  const char *d = net_transformer(evalData);
+  assert(d != NULL);
 
-  IndexList activeIndices[2];
-  activeIndices[0].size = activeIndices[1].size = 0;
-  append_active_indices(pos, activeIndices);
+  release_weights();
 
-  for (unsigned c = 0; c < 2; c++) {
-#ifdef VECTOR
-    for (unsigned i = 0; i < kHalfDimensions / TILE_HEIGHT; i++) {
-      vec16_t *ft_biases_tile = (vec16_t *)&ft_biases[i * TILE_HEIGHT];
-      vec16_t *accTile = (vec16_t *)&accumulator->accumulation[c][i * TILE_HEIGHT];
-      vec16_t acc[NUM_REGS];
+  // Read transformer, the weights of a mapped net are used in place
+  for (unsigned i = 0; i < kHalfDimensions; i++, d += 2)
+    ft_biases[i] = readu_le_u16(d);
 
-      for (unsigned j = 0; j < NUM_REGS; j++)
-        acc[j] = ft_biases_tile[j];
+  if (verify_mapped(evalData, MappedSize) && usable_in_place(d)) {
+    mapped.data = evalData;
+    ft_weights = (const int16_t *)d;
+    d += 2 * kHalfDimensions * FtInDims;
+  } else {
+    ft_copy = (int16_t *)alloc_aligned64(kHalfDimensions * FtInDims * sizeof(int16_t));
+    assert(ft_copy != NULL);
+    for (unsigned i = 0; i < kHalfDimensions * FtInDims; i++, d += 2)
+      ft_copy[i] = readu_le_u16(d);
+    ft_weights = ft_copy;
+  }
 
-      for (size_t k = 0; k < activeIndices[c].size; k++) {
-        unsigned index = activeIndices[c].values[k];
-        unsigned offset = kHalfDimensions * index + i * TILE_HEIGHT;
-        vec16_t *column = (vec16_t *)&ft_weights[offset];
+  init_kernels(d + 4);
+}
 
-        for (unsigned j = 0; j < NUM_REGS; j++)
-          acc[j] = vec_add_16(acc[j], column[j]);
-      }
+// Takes ownership of the mapping
+static bool init_compact(const void *evalData, map_t mapping)
+{
+  const char *d = (const char *)evalData;
 
-      for (unsigned j = 0; j < NUM_REGS; j++)
-        accTile[j] = acc[j];
-    }
-#else
-    memcpy(accumulator->accumulation[c], ft_biases,
-        kHalfDimensions * sizeof(int16_t));
+  release_weights();
+  compact.data = d;
+  compact.mapping = mapping;
+  compact.buckets = readu_le_u32(d + 4);
+  compact.bucketOf = (const uint8_t *)(d + 8);
+  d += CompactHeader;
 
-    for (size_t k = 0; k < activeIndices[c].size; k++) {
-      unsigned index = activeIndices[c].values[k];
-      unsigned offset = kHalfDimensions * index;
+  for (unsigned i = 0; i < kHalfDimensions; i++, d += 2)
+    ft_biases[i] = readu_le_u16(d);
+  compact.base = d;
+  compact.rows = d + 2 * (size_t)BlockSize;
 
-      for (unsigned j = 0; j < kHalfDimensions; j++)
-        accumulator->accumulation[c][j] += ft_weights[offset + j];
-    }
-#endif
-  }
+  block_cache_reset();
 
-  accumulator->computedAccumulation = 1;
+  init_kernels(compact.rows + (size_t)compact.buckets * PS_END * CompactRow + 4);
+  return true;
 }
 
-// Calculate cumulative value using difference calculation if possible
-INLINE bool update_accumulator(Position *pos)
+static bool load_eval_file(const char *evalFile)
 {
-  Accumulator *accumulator = &(pos->nnue[0]->accumulator);
-  if (accumulator->computedAccumulation)
-    return true;
-
-  Accumulator *prevAcc;
-  if (   (!pos->nnue[1] || !(prevAcc = &pos->nnue[1]->accumulator)->computedAccumulation)
-      && (!pos->nnue[2] || !(prevAcc = &pos->nnue[2]->accumulator)->computedAccumulation) )
-    return false;
-
-  IndexList removed_indices[2], added_indices[2];
-  removed_indices[0].size = removed_indices[1].size = 0;
-  added_indices[0].size = added_indices[1].size = 0;
-  bool reset[2];
-  append_changed_indices(pos, removed_indices, added_indices, reset);
-
-#ifdef VECTOR
-  for (unsigned i = 0; i< kHalfDimensions / TILE_HEIGHT; i++) {
-    for (unsigned c = 0; c < 2; c++) {
-      vec16_t *accTile = (vec16_t *)&accumulator->accumulation[c][i * TILE_HEIGHT];
-      vec16_t acc[NUM_REGS];
-
-      if (reset[c]) {
-        vec16_t *ft_b_tile = (vec16_t *)&ft_biases[i * TILE_HEIGHT];
-        for (unsigned j = 0; j < NUM_REGS; j++)
-          acc[j] = ft_b_tile[j];
-      } else {
-        vec16_t *prevAccTile = (vec16_t *)&prevAcc->accumulation[c][i * TILE_HEIGHT];
-        for (unsigned j = 0; j < NUM_REGS; j++)
-          acc[j] = prevAccTile[j];
-
-        // Difference calculation for the deactivated features
-        for (unsigned k = 0; k < removed_indices[c].size; k++) {
-          unsigned index = removed_indices[c].values[k];
-          const unsigned offset = kHalfDimensions * index + i * TILE_HEIGHT;
-
-          vec16_t *column = (vec16_t *)&ft_weights[offset];
-          for (unsigned j = 0; j < NUM_REGS; j++)
-            acc[j] = vec_sub_16(acc[j], column[j]);
-        }
-      }
-
-      // Difference calculation for the activated features
-      for (unsigned k = 0; k < added_indices[c].size; k++) {
-        unsigned index = added_indices[c].values[k];
-        const unsigned offset = kHalfDimensions * index + i * TILE_HEIGHT;
-
-        vec16_t *column = (vec16_t *)&ft_weights[offset];
-        for (unsigned j = 0; j < NUM_REGS; j++)
-          acc[j] = vec_add_16(acc[j], column[j]);
-      }
+  const void *evalData;
+  map_t mapping;
+  size_t size;
 
-      for (unsigned j = 0; j < NUM_REGS; j++)
-        accTile[j] = acc[j];
-    }
+  {
+    FD fd = open_file(evalFile);
+    if (fd == FD_ERR) return false;
+    evalData = map_file(fd, &mapping);
+    size = file_size(fd);
+    close_file(fd);
   }
-#else
-  for (unsigned c = 0; c < 2; c++) {
-    if (reset[c]) {
-      memcpy(accumulator->accumulation[c], ft_biases,
-          kHalfDimensions * sizeof(int16_t));
-    } else {
-      memcpy(accumulator->accumulation[c], prevAcc->accumulation[c],
-          kHalfDimensions * sizeof(int16_t));
-      // Difference calculation for the deactivated features
-      for (unsigned k = 0; k < removed_indices[c].size; k++) {
-        unsigned index = removed_indices[c].values[k];
-        const unsigned offset = kHalfDimensions * index;
 
-        for (unsigned j = 0; j < kHalfDimensions; j++)
-          accumulator->accumulation[c][j] -= ft_weights[offset + j];
-      }
-    }
+  if (evalData && verify_compact(evalData, size))
+    return init_compact(evalData, mapping);
 
-    // Difference calculation for the activated features
-    for (unsigned k = 0; k < added_indices[c].size; k++) {
-      unsigned index = added_indices[c].values[k];
-      const unsigned offset = kHalfDimensions * index;
-
-      for (unsigned j = 0; j < kHalfDimensions; j++)
-        accumulator->accumulation[c][j] += ft_weights[offset + j];
-    }
-  }
-#endif
+  bool success = evalData && (verify_net(evalData, size) || verify_mapped(evalData, size));
+  if (success)
+    init_weights(evalData);
+  if (success && mapped.data == evalData)
+    mapped.mapping = mapping; // released with the net
+  else if (mapping)
+    unmap_file(evalData, mapping);
+  return success;
+}
 
-  accumulator->computedAccumulation = 1;
-  return true;
+static void put_u32(FILE *f, uint32_t v)
+{
+  unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8),
+                         (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+  fwrite(b, 1, 4, f);
 }
 
-// Convert input features
-INLINE void transform(Position *pos, clipped_t *output, mask_t *outMask)
+static void put_u16(FILE *f, int v)
 {
-  if (!update_accumulator(pos))
-    refresh_accumulator(pos);
-
-  int16_t (*accumulation)[2][256] = &pos->nnue[0]->accumulator.accumulation;
-  (void)outMask; // avoid compiler warning
-
-  const int perspectives[2] = { pos->player, !pos->player };
-  for (unsigned p = 0; p < 2; p++) {
-    const unsigned offset = kHalfDimensions * p;
-
-#ifdef VECTOR
-    const unsigned numChunks = (16 * kHalfDimensions) / SIMD_WIDTH;
-    vec8_t *out = (vec8_t *)&output[offset];
-    for (unsigned i = 0; i < numChunks / 2; i++) {
-      vec16_t s0 = ((vec16_t *)(*accumulation)[perspectives[p]])[i * 2];
-      vec16_t s1 = ((vec16_t *)(*accumulation)[perspectives[p]])[i * 2 + 1];
-      out[i] = vec_packs(s0, s1);
-      *outMask++ = vec_mask_pos(out[i]);
-    }
+  unsigned char b[2] = { (unsigned char)v, (unsigned char)(v >> 8) };
+  fwrite(b, 1, 2, f);
+}
 
-#else
-    for (unsigned i = 0; i < kHalfDimensions; i++) {
-      int16_t sum = (*accumulation)[perspectives[p]][i];
-      output[offset + i] = clamp(sum, 0, 127);
-    }
+// King buckets as rank groups x file groups, ranks get the finer split
+static unsigned bucket_of(unsigned ksq, unsigned buckets)
+{
+  unsigned bits = 0;
+  while ((2u << bits) <= buckets) bits++;
+  unsigned fileBits = bits / 2, rankBits = bits - fileBits;
 
-#endif
+  return ((ksq >> 3) >> (3 - rankBits) << fileBits) | ((ksq & 7) >> (3 - fileBits));
+}
 
-  }
+/*
+Interfaces
+*/
+int nnue_evaluate_pos(Position *pos)
+{
+  return kernel->evaluate_pos(pos);
 }
 
-struct NetData {
-  alignas(64) clipped_t input[FtOutDims];
-  clipped_t hidden1_out[32];
-#if (defined(USE_SSE2) || defined(USE_MMX)) && !defined(USE_AVX2)
-  int16_t hidden2_out[32];
-#else
-  int8_t hidden2_out[32];
-#endif
-};
+DLLExport const char * _CDECL nnue_kernel_name()
+{
+  return kernel ? kernel->name : "none";
+}
 
-// Evaluation function
-int nnue_evaluate_pos(Position *pos)
+DLLExport int _CDECL nnue_set_kernel(const char *name)
 {
-  int32_t out_value;
-  alignas(8) mask_t input_mask[FtOutDims / (8 * sizeof(mask_t))];
-  alignas(8) mask_t hidden1_mask[8 / sizeof(mask_t)] = { 0 };
-#ifdef ALIGNMENT_HACK // work around a bug in old gcc on Windows
-  uint8_t buf[sizeof(struct NetData) + 63];
-  struct NetData *b = (struct NetData *)(buf + ((((uintptr_t)buf-1) ^ 0x3f) & 0x3f));
-#define B(x) (b->x)
-#else
-  struct NetData buf;
-#define B(x) (buf.x)
-#endif
+  for (unsigned i = 0; i < KernelNb; i++)
+    if (!strcmp(Kernels[i]->name, name) && kernel_supported(i)) {
+      kernel = Kernels[i];
+      return 1;
+    }
 
-  transform(pos, B(input), input_mask);
+  return 0;
+}
 
-  affine_txfm(B(input), B(hidden1_out), FtOutDims, 32,
-      hidden1_biases, hidden1_weights, input_mask, hidden1_mask, true);
+DLLExport int _CDECL nnue_init(const char* evalFile)
+{
+  printf("Loading NNUE : %s\n", evalFile);
+  fflush(stdout);
 
-  affine_txfm(B(hidden1_out), B(hidden2_out), 32, 32,
-      hidden2_biases, hidden2_weights, hidden1_mask, NULL, false);
+  if (load_eval_file(evalFile)) {
+    if (compact.data)
+      printf("NNUE loaded ! (%s, %u king buckets, %u cached per thread)\n",
+          nnue_kernel_name(), compact.buckets, blockSlotNb);
+    else if (mapped.data)
+      printf("NNUE loaded ! (%s, mapped)\n", nnue_kernel_name());
+    else
+      printf("NNUE loaded ! (%s)\n", nnue_kernel_name());
+    fflush(stdout);
+    return 1;
+  }
 
-  out_value = affine_propagate((int8_t *)B(hidden2_out), output_biases,
-      output_weights);
+  printf("NNUE file not found!\n");
+  fflush(stdout);
+  return 0;
+}
 
-#if defined(USE_MMX)
-  _mm_empty();
-#endif
+DLLExport void _CDECL nnue_set_cache_size(size_t bytes)
+{
+  blockCacheBytes = bytes;
+  if (compact.data)
+    block_cache_reset();
+}
 
-  return out_value / FV_SCALE;
+DLLExport void _CDECL nnue_cache_stats(uint64_t *hits, uint64_t *misses)
+{
+  *hits = nnue_block_stats.hits;
+  *misses = nnue_block_stats.misses;
 }
 
-static void read_output_weights(weight_t *w, const char *d)
+DLLExport int _CDECL nnue_is_mapped()
 {
-  for (unsigned i = 0; i < 32; i++) {
-    unsigned c = i;
-#if defined(USE_AVX512)
-    unsigned b = c & 0x18;
-    b = (b << 1) | (b >> 1);
-    c = (c & ~0x18) | (b & 0x18);
-#endif
-    w[c] = *d++;
-  }
+  return mapped.data != NULL;
 }
 
-INLINE unsigned wt_idx(unsigned r, unsigned c, unsigned dims)
+DLLExport int _CDECL nnue_write_compact(
+  const void *evalData, const char *outFile, unsigned buckets)
 {
-  (void)dims;
+  if (buckets < 1 || buckets > 64 || (buckets & (buckets - 1)))
+    return 0;
 
-#if defined(USE_AVX512)
-  if (dims > 32) {
-    unsigned b = c & 0x38;
-    b = (b << 1) | (b >> 2);
-    c = (c & ~0x38) | (b & 0x38);
-  }
-  else if (dims == 32) {
-    unsigned b = c & 0x18;
-    b = (b << 1) | (b >> 1);
-    c = (c & ~0x18) | (b & 0x18);
-  }
+  const char *d = net_transformer(evalData);
+  if (!d) return 0;
 
-#elif defined(USE_AVX2)
-  if (dims > 32) {
-    unsigned b = c & 0x18;
-    b = (b << 1) | (b >> 1);
-    c = (c & ~0x18) | (b & 0x18);
+  FILE *f = fopen(outFile, "wb");
+  if (!f) return 0;
+
+  const char *w = d + 2 * kHalfDimensions;
+
+  put_u32(f, CompactMagic);
+  put_u32(f, buckets);
+  for (unsigned k = 0; k < 64; k++)
+    fputc(bucket_of(k, buckets), f);
+  fwrite(d, 2, kHalfDimensions, f);
+
+  // Base: mean over all king squares, bucket: mean over its king squares
+  int *sum = (int *)malloc(sizeof(int) * kHalfDimensions);
+  int16_t *base = (int16_t *)malloc(2 * (size_t)BlockSize);
+
+  for (unsigned i = 0; i < PS_END; i++) {
+    memset(sum, 0, sizeof(int) * kHalfDimensions);
+    for (unsigned k = 0; k < 64; k++)
+      for (unsigned j = 0; j < kHalfDimensions; j++)
+        sum[j] += (int16_t)readu_le_u16(w + 2 * ((size_t)BlockSize * k + i * kHalfDimensions + j));
+    for (unsigned j = 0; j < kHalfDimensions; j++) {
+      base[i * kHalfDimensions + j] = (int16_t)(sum[j] >= 0 ? (sum[j] + 32) / 64 : -((-sum[j] + 32) / 64));
+      put_u16(f, base[i * kHalfDimensions + j]);
+    }
   }
 
-#endif
+  for (unsigned b = 0; b < buckets; b++)
+    for (unsigned i = 0; i < PS_END; i++) {
+      int n = 0, maxAbs = 0;
+      memset(sum, 0, sizeof(int) * kHalfDimensions);
+      for (unsigned k = 0; k < 64; k++) {
+        if (bucket_of(k, buckets) != b) continue;
+        n++;
+        for (unsigned j = 0; j < kHalfDimensions; j++)
+          sum[j] += (int16_t)readu_le_u16(w + 2 * ((size_t)BlockSize * k + i * kHalfDimensions + j));
+      }
+      for (unsigned j = 0; j < kHalfDimensions; j++) {
+        int mean = sum[j] >= 0 ? (sum[j] + n / 2) / n : -((-sum[j] + n / 2) / n);
+        sum[j] = mean - base[i * kHalfDimensions + j];
+        if (abs(sum[j]) > maxAbs) maxAbs = abs(sum[j]);
+      }
 
-#if defined(USE_AVX512)
-  return c * 64 + r + (r & ~7);
+      // residual = (q * scale + 128) >> 8, exact whenever it fits in int8
+      int scale = maxAbs <= 127 ? 256 : (maxAbs * 256 + 126) / 127;
+      put_u32(f, scale);
+      for (unsigned j = 0; j < kHalfDimensions; j++) {
+        int q = (int)((sum[j] * 256 + (sum[j] >= 0 ? scale / 2 : -scale / 2)) / scale);
+        fputc((int8_t)(q > 127 ? 127 : q < -127 ? -127 : q), f);
+      }
+    }
 
-#else
-  return c * 32 + r;
+  free(sum);
+  free(base);
 
-#endif
+  fwrite(d + TransformerSize, 1, NetSize - NetworkStart, f);
+  bool ok = !ferror(f);
+  return fclose(f) == 0 && ok;
 }
 
-static const char *read_hidden_weights(weight_t *w, unsigned dims,
-    const char *d)
+DLLExport int _CDECL nnue_write_mapped(const void *evalData, const char *outFile)
 {
-  for (unsigned r = 0; r < 32; r++)
-    for (unsigned c = 0; c < dims; c++)
-      w[wt_idx(r, c, dims)] = *d++;
+  const char *d = net_transformer(evalData);
+  if (!d) return 0;
 
-  return d;
-}
+  FILE *f = fopen(outFile, "wb");
+  if (!f) return 0;
 
-#ifdef USE_AVX2
-static void permute_biases(int32_t *biases)
-{
-  __m128i *b = (__m128i *)biases;
-  __m128i tmp[8];
-#ifdef USE_AVX512
-  tmp[0] = b[0];
-  tmp[1] = b[2];
-  tmp[2] = b[4];
-  tmp[3] = b[6];
-  tmp[4] = b[1];
-  tmp[5] = b[3];
-  tmp[6] = b[5];
-  tmp[7] = b[7];
-#elif USE_AVX2
-  tmp[0] = b[0];
-  tmp[1] = b[4];
-  tmp[2] = b[1];
-  tmp[3] = b[5];
-  tmp[4] = b[2];
-  tmp[5] = b[6];
-  tmp[6] = b[3];
-  tmp[7] = b[7];
-#else
-#error
-#endif
-  memcpy(b, tmp, 8 * sizeof(__m128i));
+  put_u32(f, MappedMagic);
+  put_u32(f, NnueVersion);
+  for (unsigned i = 8; i < MappedHeader; i++)
+    fputc(0, f);
+  fwrite(d, 1, NetSize - TransformerStart - 4, f);
+  bool ok = !ferror(f);
+  return fclose(f) == 0 && ok;
 }
-#endif
 
-enum {
-  TransformerStart = 3 * 4 + 177,
-  NetworkStart = TransformerStart + 4 + 2 * 256 + 2 * 256 * 64 * 641
-};
-
-static bool verify_net(const void *evalData, size_t size)
+DLLExport void _CDECL nnue_benchmark(const char **fens, int iterations)
 {
-  if (size != 21022697) return false;
+  const NNUEKernel *current = kernel;
+  int reference[64];
+  unsigned fenNb = 0;
 
-  const char *d = (const char*)evalData;
-  if (readu_le_u32(d) != NnueVersion) return false;
-  if (readu_le_u32(d + 4) != 0x3e5aa6eeU) return false;
-  if (readu_le_u32(d + 8) != 177) return false;
-  if (readu_le_u32(d + TransformerStart) != 0x5d69d7b8) return false;
-  if (readu_le_u32(d + NetworkStart) != 0x63337156) return false;
+  while (fens[fenNb] && fenNb < 64) fenNb++;
 
-  return true;
-}
+  for (unsigned i = KernelNb; i-- > 0; ) { // scalar first, as the reference
+    if (!kernel_supported(i)) continue;
+    kernel = Kernels[i];
 
-DLLExport void _CDECL init_weights(const void *evalData)
-{
-  const char *d = (const char *)evalData + TransformerStart + 4;
+    double full = 0, layers = 0;
+    bool match = true;
 
-  // Read transformer
-  for (unsigned i = 0; i < kHalfDimensions; i++, d += 2)
-    ft_biases[i] = readu_le_u16(d);
-  for (unsigned i = 0; i < kHalfDimensions * FtInDims; i++, d += 2)
-    ft_weights[i] = readu_le_u16(d);
-
-  // Read network
-  d += 4;
-  for (unsigned i = 0; i < 32; i++, d += 4)
-    hidden1_biases[i] = readu_le_u32(d);
-  d = read_hidden_weights(hidden1_weights, 512, d);
-  for (unsigned i = 0; i < 32; i++, d += 4)
-    hidden2_biases[i] = readu_le_u32(d);
-  d = read_hidden_weights(hidden2_weights, 32, d);
-  for (unsigned i = 0; i < 1; i++, d += 4)
-    output_biases[i] = readu_le_u32(d);
-  read_output_weights(output_weights, d);
-
-#ifdef USE_AVX2
-  permute_biases(hidden1_biases);
-  permute_biases(hidden2_biases);
-#endif
-}
+    for (unsigned f = 0; f < fenNb; f++) {
+      int pieces[33], squares[33], player, castle, fifty, move_number;
+      decode_fen((char *)fens[f], &player, &castle, &fifty, &move_number, pieces, squares);
 
-static bool load_eval_file(const char *evalFile)
-{
-  const void *evalData;
-  map_t mapping;
-  size_t size;
+      NNUEdata nnue;
+      Position pos;
+      pos.nnue[0] = &nnue;
+      pos.nnue[1] = 0;
+      pos.nnue[2] = 0;
+      pos.player = player;
+      pos.pieces = pieces;
+      pos.squares = squares;
 
-  {
-    FD fd = open_file(evalFile);
-    if (fd == FD_ERR) return false;
-    evalData = map_file(fd, &mapping);
-    size = file_size(fd);
-    close_file(fd);
-  }
+      // accumulator refresh + all layers
+      int score = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (int n = 0; n < iterations; n++) {
+        nnue.accumulator.computedAccumulation = 0;
+        score += nnue_evaluate_pos(&pos);
+      }
+      auto mid = std::chrono::steady_clock::now();
 
-  bool success = verify_net(evalData, size);
-  if (success)
-    init_weights(evalData);
-  if (mapping) unmap_file(evalData, mapping);
-  return success;
-}
+      // accumulator up to date: the network layers only
+      for (int n = 0; n < iterations; n++)
+        score += nnue_evaluate_pos(&pos);
+      auto end = std::chrono::steady_clock::now();
 
-/*
-Interfaces
-*/
-DLLExport void _CDECL nnue_init(const char* evalFile)
-{
-  printf("Loading NNUE : %s\n", evalFile);
-  fflush(stdout);
+      full += std::chrono::duration<double, std::nano>(mid - start).count();
+      layers += std::chrono::duration<double, std::nano>(end - mid).count();
 
-  if (load_eval_file(evalFile)) {
-    printf("NNUE loaded !\n");
+      if (i == KernelNb - 1)
+        reference[f] = score;
+      else if (score != reference[f])
+        match = false;
+    }
+
+    printf("%-10s full %8.1f ns/eval   layers %8.1f ns/eval%s\n", kernel->name,
+        full / (fenNb * iterations), layers / (fenNb * iterations),
+        match ? "" : "   MISMATCH");
     fflush(stdout);
-    return;
   }
 
-  printf("NNUE file not found!\n");
-  fflush(stdout);
+  kernel = current;
 }
 
 DLLExport int _CDECL nnue_evaluate(
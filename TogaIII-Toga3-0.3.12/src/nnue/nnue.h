@@ -1,6 +1,9 @@
 #ifndef NNUE_H
 #define NNUE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifndef __cplusplus
 #ifndef _MSC_VER
 #include <stdalign.h>
@@ -96,19 +99,82 @@ int nnue_evaluate_pos(Position* pos);
 **************************************************************************/
 
 /**
-* Load NNUE file
+* Load NNUE file: a full net, a mapped one written by @nnue_write_mapped
+* or a compact one written by @nnue_write_compact. Returns 0 on failure.
 */
-DLLExport void _CDECL nnue_init(
+DLLExport int _CDECL nnue_init(
   const char * evalFile             /** Path to NNUE file */
 );
 
 /**
-* Init NNUE weights
+* Memory budget per thread for the decoded king blocks of a compact net (one
+* block is about 320 KB, at least two are kept). Each thread resizes its
+* cache on its next evaluation.
+*/
+DLLExport void _CDECL nnue_set_cache_size(size_t bytes);
+
+/**
+* Decoded king block cache hits and misses of all threads since the compact
+* net was loaded (hits are counted on each thread's next miss)
+*/
+DLLExport void _CDECL nnue_cache_stats(uint64_t *hits, uint64_t *misses);
+
+/**
+* Write a compact copy of a full net: the 64 king square blocks of the
+* feature transformer are merged into a power of two number of king buckets
+* (1 to 64), stored as a shared base plus int8 residuals. Lossy except for
+* the network layers. Returns 0 on failure.
+*/
+DLLExport int _CDECL nnue_write_compact(
+  const void * evalData,            /** Full or mapped net in memory */
+  const char * outFile,             /** Path of the compact net */
+  unsigned buckets                  /** Number of king buckets */
+);
+
+/**
+* Write a mapped copy of a full net: same weights, with a 64 byte header so
+* that the transformer is cache line aligned. Such a net is used in place
+* from the file mapping (or from .rodata when embedded) instead of being
+* copied, and its pages are shared by all the engines on the host.
+* Returns 0 on failure.
+*/
+DLLExport int _CDECL nnue_write_mapped(
+  const void * evalData,            /** Full or mapped net in memory */
+  const char * outFile              /** Path of the mapped net */
+);
+
+/**
+* Whether the current net is used in place (mapped net)
+*/
+DLLExport int _CDECL nnue_is_mapped();
+
+/**
+* Init NNUE weights from a full or mapped net. A mapped net is used in
+* place and must stay valid until the next net is loaded.
 */
 DLLExport void _CDECL init_weights(const void *evalData);
 
 
 
+/**
+* Name of the SIMD kernel in use (picked from CPUID when built with USE_DISPATCH)
+*/
+DLLExport const char * _CDECL nnue_kernel_name();
+
+/**
+* Force a kernel by name (avx512vnni, avx512bw, avx2, sse41, ssse3, sse2,
+* scalar).
+* Returns 0 if it is unknown or not supported by this host.
+*/
+DLLExport int _CDECL nnue_set_kernel(const char *name);
+
+/**
+* Time every kernel this host supports on a NULL terminated FEN list (up to
+* 64) and print ns/eval with a full accumulator refresh and with the network
+* layers only. Scores are checked against the scalar kernel.
+*/
+DLLExport void _CDECL nnue_benchmark(const char **fens, int iterations);
+
 /**
 * Evaluate on FEN string
 * Returns
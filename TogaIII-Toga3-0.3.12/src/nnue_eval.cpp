@@ -3,11 +3,18 @@
 // include headers
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "./nnue/nnue.h"
 #include "nnue_eval.h"
+#include "eval_cache.h"
+#include "option.h"
+#include "util.h"
 
 extern const unsigned char _binary_toganet_bin_start[];
 
+// Stockfish NNUE piece encoding
+int nnue_pieces[13] = {6, 12, 5, 11, 4, 10, 3, 9, 2, 8, 1, 7, 0};
+
 // init NNUE
 void init_nnue(char *filename)
 {
@@ -20,10 +27,61 @@ void init_nnue_embedded()
 {
   init_weights(_binary_toganet_bin_start);
   
-  printf("Embedded NNUE loaded !\n");
+  printf("Embedded NNUE loaded ! (%s%s)\n", nnue_kernel_name(), nnue_is_mapped() ? ", mapped" : "");
   fflush(stdout);
 }
 
+// (re)load the net from the UCI options, only when they changed
+void nnue_parameter()
+{
+  static char loaded[256] = "";
+  static int cache = -1;
+  const char *file = option_get_string("NNUE File");
+
+  if (cache != option_get_int("NNUE Cache")) {
+    cache = option_get_int("NNUE Cache");
+    nnue_set_cache_size((size_t)cache * 1024 * 1024);
+  }
+
+  if (strcmp(loaded, file) == 0) return;
+  snprintf(loaded, sizeof(loaded), "%s", file);
+
+  if (my_string_empty(file) || strcmp(file, "<embedded>") == 0 || !nnue_init(file))
+    init_nnue_embedded();
+
+  // cached scores belong to the previous net
+  eval_cache_clear();
+}
+
+// write a compact copy of the embedded net
+bool write_compact_nnue(const char *filename, int buckets)
+{
+  return nnue_write_compact(_binary_toganet_bin_start, filename, buckets) != 0;
+}
+
+// write a mapped copy of the embedded net
+bool write_mapped_nnue(const char *filename)
+{
+  return nnue_write_mapped(_binary_toganet_bin_start, filename) != 0;
+}
+
+// time the NNUE kernels on the embedded net
+void bench_nnue(int iterations)
+{
+  static const char *fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    NULL
+  };
+
+  init_nnue_embedded();
+  printf("NNUE kernels, %d evals per position\n", iterations);
+  nnue_benchmark(fens, iterations);
+}
+
 // get NNUE score directly
 int evaluate_nnue(int player, int *pieces, int *squares)
 {
@@ -31,6 +89,13 @@ int evaluate_nnue(int player, int *pieces, int *squares)
   return nnue_evaluate(player, pieces, squares);
 }
 
+// get NNUE score updating the accumulator of the current ply from its parents
+int evaluate_nnue_incremental(int player, int *pieces, int *squares, NNUEdata **nnue)
+{
+  // call NNUE probe lib function
+  return nnue_evaluate_incremental(player, pieces, squares, nnue);
+}
+
 // det NNUE score from FEN input
 int evaluate_fen_nnue(char *fen)
 {
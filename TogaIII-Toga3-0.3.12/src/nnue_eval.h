@@ -1,5 +1,15 @@
 /* NNUE wrapper function headers */
+struct NNUEdata;
+
+// Stockfish NNUE piece encoding, indexed by PIECE_TO_12()
+extern int nnue_pieces[13];
+
 void init_nnue(char *filename);
 void init_nnue_embedded();
+void nnue_parameter();
+bool write_compact_nnue(const char *filename, int buckets);
+bool write_mapped_nnue(const char *filename);
+void bench_nnue(int iterations);
 int evaluate_nnue(int player, int *pieces, int *squares);
+int evaluate_nnue_incremental(int player, int *pieces, int *squares, NNUEdata **nnue);
 int evaluate_fen_nnue(char *fen);
@@ -79,11 +79,19 @@ static option_t Option[] = {
    { "Toga Lazy Eval Margin",  true, "200",    "spin",  "min 0 max 900", NULL },
    { "Toga Lazy Eval Mobility Margin",  true, "125",    "spin",  "min 0 max 900", NULL },
    
+   { "Use NNUE",          true, "true", "check", "", NULL },
+   { "NNUE Lazy Margin",  true, "800",  "spin",  "min 0 max 10000", NULL },
+   { "NNUE Eval Cache",   true, "4",    "spin",  "min 1 max 256", NULL },
+
    { "Toga Exchange Bonus",  false, "20",    "spin",  "min 0 max 100", NULL }, 
    { "Toga King Pawn Endgame Bonus",  true, "30",    "spin",  "min 0 max 100", NULL },
    { "Toga Rook Pawn Endgame Penalty",  true, "10",    "spin",  "min 0 max 100", NULL },
    
    { "Number of Threads",   true, "1",   "spin",  "min 1 max 64", NULL },
+   { "NUMA Binding",        true, "true", "check", "", NULL },
+
+   { "NNUE File",  true, "<embedded>", "string", "", NULL },
+   { "NNUE Cache", true, "8",          "spin",   "min 1 max 64", NULL },
    
    { NULL, false, NULL, NULL, NULL, NULL, },
 };
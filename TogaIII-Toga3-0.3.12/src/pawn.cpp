@@ -170,7 +170,7 @@ void pawn_parameter() {
 
 void pawn_init() {
 
-   int rank, file, ThreadId;
+   int rank, file;
 
    // UCI options
 
@@ -204,50 +204,25 @@ void pawn_init() {
    FileBonus[FileF] = 1;
    //FileBonus[FileG] = 0;
    //FileBonus[FileH] = 0;
-
-   // pawn hash-table
-
-	for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		Pawn[ThreadId]->size = 0;
-		Pawn[ThreadId]->mask = 0;
-		Pawn[ThreadId]->table = NULL;
-	}
 }
 
 // pawn_alloc()
 
-void pawn_alloc() {
-	
-	int ThreadId;
-
-   ASSERT(sizeof(entry_t)==16);
-
-   if (UseTable) {
-		
-		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-			Pawn[ThreadId]->size = TableSize;
-			Pawn[ThreadId]->mask = TableSize - 1;
-			Pawn[ThreadId]->table = (entry_t *) my_malloc(Pawn[ThreadId]->size*sizeof(entry_t));
-
-			pawn_clear(ThreadId);
-		}
-   }
-}
+// called once by the owning thread, so the table is local to its NUMA node
 
-// pawn_free()
-
-void pawn_free() {
-	
-	int ThreadId;
+void pawn_alloc(int ThreadId) {
 
    ASSERT(sizeof(entry_t)==16);
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+   ASSERT(Pawn[ThreadId]->table==NULL);
 
    if (UseTable) {
-		
-                for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
 
-		  my_free(Pawn[ThreadId]->table);
-		}
+      Pawn[ThreadId]->size = TableSize;
+      Pawn[ThreadId]->mask = TableSize - 1;
+      Pawn[ThreadId]->table = (entry_t *) my_malloc(Pawn[ThreadId]->size*sizeof(entry_t));
+
+      pawn_clear(ThreadId);
    }
 }
 
@@ -53,8 +53,7 @@ extern void pawn_init_bit ();
 extern void pawn_parameter();
 extern void pawn_init     ();
 
-extern void pawn_alloc    ();
-extern void pawn_free    ();
+extern void pawn_alloc    (int ThreadId);
 extern void pawn_clear    (int ThreadId);
 
 extern void pawn_get_info (pawn_info_t * info, const board_t * board, int ThreadId);
@@ -11,14 +11,17 @@
 #include <windows.h>
 #endif
 
+#include "bench.h"
 #include "board.h"
 #include "book.h"
 #include "eval.h"
+#include "eval_cache.h"
 #include "fen.h"
 #include "material.h"
 #include "move.h"
 #include "move_do.h"
 #include "move_legal.h"
+#include "nnue_eval.h"
 #include "option.h"
 #include "pawn.h"
 #include "posix.h"
@@ -56,9 +59,9 @@ static bool Delay; // postpone "bestmove" in infinite/ponder mode?
 
 // prototypes
 
-static void init              ();
 static void loop_step         ();
 
+static void parse_bench       (char string[]);
 static void parse_go          (char string[]);
 static void parse_position    (char string[]);
 static void parse_setoption   (char string[]);
@@ -105,7 +108,7 @@ void loop() {
 
 // init()
 
-static void init() {
+void init() {
 	
    if (!Init) {
 
@@ -113,28 +116,23 @@ static void init() {
 
       Init = true;
 
-      NumberThreads=option_get_int("Number of Threads");
-      if(NumberThreads>MaxThreads) NumberThreads=MaxThreads;
-		
       book_parameter();
+      nnue_parameter();
       
 	   //SearchInput->multipv = option_get_int("MultiPV");
 
       trans_alloc(Trans);
 
       pawn_init();
-      pawn_alloc();
-
       material_init();
-      material_alloc();
 
       pst_init();
       eval_init();
 #ifdef _WIN32
 	  InitializeCriticalSection(&CriticalSection);
 #endif
-	  SearchInput->exit_engine = false;
-	  start_suspend_threads();
+
+      threads_set(option_get_int("Number of Threads"));
    }
 
 }
@@ -167,6 +165,15 @@ static void loop_step() {
 
    if (false) {
 
+   } else if (string_equal(string,"bench") || string_start_with(string,"bench ")) {
+
+      if (!Searching && !Delay) {
+         init();
+         parse_bench(string);
+      } else {
+         ASSERT(false);
+      }
+
    } else if (string_start_with(string,"debug ")) {
 
       // dummy
@@ -221,8 +228,7 @@ static void loop_step() {
       ASSERT(!Searching);
       ASSERT(!Delay);
 
-	  SearchInput->exit_engine = true;
-	  resume_threads();
+      threads_exit();
       exit(EXIT_SUCCESS);
 
    } else if (string_start_with(string,"setoption ")) {
@@ -232,6 +238,7 @@ static void loop_step() {
 		 pawn_parameter();
 		 material_parameter();
 		 book_parameter();
+		 if (Init) nnue_parameter();
 		 pst_init();
 		 eval_parameter();
       } else {
@@ -276,6 +283,23 @@ static void loop_step() {
    }
 }
 
+// parse_bench()
+
+static void parse_bench(char string[]) {
+
+   int depth, threads, hash;
+
+   // "bench [depth] [threads] [hash]"
+
+   depth = BenchDepth;
+   threads = 1;
+   hash = BenchHash;
+
+   sscanf(string,"bench %d %d %d",&depth,&threads,&hash);
+
+   bench(depth,threads,hash);
+}
+
 // parse_go()
 
 static void parse_go(char string[]) {
@@ -593,20 +617,20 @@ static void parse_setoption(char string[]) {
       }
    }
    
+   if (Init && my_string_equal(name,"NNUE Eval Cache")) {
+
+      ASSERT(!Searching);
+
+      threads_cache_resize();
+   }
+
    if (Init && my_string_equal(name,"Number of Threads")) { // Init => already started
      
      ASSERT(!Searching);
      
      if (option_get_int("Number of Threads")!= NumberThreads) {
-       exit_threads();
-       pawn_free();
-       material_free();
-       NumberThreads=option_get_int("Number of Threads");
-       if(NumberThreads>MaxThreads) NumberThreads=MaxThreads;
-       pawn_alloc();
-       material_alloc();
+       threads_set(option_get_int("Number of Threads")); // existing helpers are kept
        search_clear();
-       start_suspend_threads();
      }
    }
 }
@@ -642,6 +666,8 @@ static void send_best_move() {
    send("info time %.0f nodes " S64_FORMAT " nps %.0f cpuload %.0f",time*1000.0,node_nb,speed,cpu*1000.0);
 
    trans_stats(Trans);
+   eval_stats();
+   eval_cache_stats();
    // pawn_stats();
    // material_stats();
 
@@ -697,6 +723,8 @@ void send(const char format[], ...) {
 
    ASSERT(format!=NULL);
 
+   if (SearchInput->quiet) return;
+
    va_start(arg_list,format);
    vsprintf(string,format,arg_list);
    va_end(arg_list);
@@ -22,6 +22,7 @@ extern  pthread_mutex_t CriticalSection;
 
 // functions
 
+extern void init  ();
 extern void loop  ();
 extern void event ();
 extern void book_parameter();
@@ -20,6 +20,7 @@
 #include "board.h"
 #include "book.h"
 #include "colour.h"
+#include "eval_cache.h"
 #include "list.h"
 #include "material.h"
 #include "move.h"
@@ -61,15 +62,40 @@ static const bool UseBad = true;
 static const int BadThreshold = 50; // 50
 static const bool UseExtension = true;
 
+// lazy SMP: helper i skips the iterations where (depth + SkipPhase) / SkipSize
+// is odd, so the helpers spread over the next few depths instead of all
+// searching the same one (pattern from Stockfish)
+
+static const int SkipNb = 20;
+static const int SkipSize[SkipNb]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int SkipPhase[SkipNb] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// helper thread jobs
+
+enum thread_job_t {
+   JobSearch,
+   JobCache, // resize the eval cache on the helper's own node
+   JobExit
+};
+
 // variables
 
 static search_multipv_t save_multipv[MultiPVMax];
+
+// thread pool: helpers 1..ThreadNb-1 are created on demand and sleep on
+// ThreadWake[] between jobs; threads beyond NumberThreads just stay asleep
+
 #ifdef _WIN32
-static HANDLE threat_handle[MaxThreads];
+static HANDLE ThreadHandle[MaxThreads];
 #else
-static pthread_t threat_handle[MaxThreads];
-static my_sem_t thread_runnable[MaxThreads];
+static pthread_t ThreadHandle[MaxThreads];
 #endif
+static my_sem_t ThreadWake[MaxThreads];
+static my_sem_t ThreadDone[MaxThreads];
+static volatile int ThreadJob[MaxThreads];
+static int ThreadIds[MaxThreads];
+static int ThreadNb = 0; // threads with allocated state, main thread included
+static bool ThreadBind;
 
 int NumberThreads = 1;
 
@@ -77,18 +103,21 @@ int NumberThreads = 1;
 //CRITICAL_SECTION CriticalSection; 
 
 search_input_t SearchInput[1];
-search_info_t SearchInfo[MaxThreads][1];
-search_root_t SearchRoot[MaxThreads][1];
-search_current_t SearchCurrent[MaxThreads][1];
-search_best_t SearchBest[MaxThreads][MultiPVMax];
+search_info_t * SearchInfo[MaxThreads];
+search_root_t * SearchRoot[MaxThreads];
+search_current_t * SearchCurrent[MaxThreads];
+search_best_t * SearchBest[MaxThreads];
 
 // prototypes
 
 static void search_send_stat (int ThreadId);
+
+static void thread_alloc     (int ThreadId);
+static void thread_run       (int ThreadId, int job);
 #ifdef _WIN32
-unsigned __stdcall search_thread (void *param);
+static unsigned __stdcall thread_loop (void * param);
 #else
-void * search_thread (void *param);
+static void * thread_loop    (void * param);
 #endif
 
 // functions
@@ -112,6 +141,7 @@ bool height_is_ok(int height) {
 void search_clear() {
 
 	int ThreadId;
+	int i;
 
    // SearchInput
 
@@ -128,7 +158,6 @@ void search_clear() {
 		SearchInfo[ThreadId]->can_stop = false;
 		SearchInfo[ThreadId]->stop = false;
 		SearchInfo[ThreadId]->stopped = false;
-		SearchInfo[ThreadId]->exited = false;
 		SearchInfo[ThreadId]->check_nb = 10000; // was 100000
 		SearchInfo[ThreadId]->check_inc = 10000; // was 100000
 		SearchInfo[ThreadId]->last_time = 0.0;
@@ -158,79 +187,188 @@ void search_clear() {
 
 		SearchCurrent[ThreadId]->max_depth = 0;
 		SearchCurrent[ThreadId]->node_nb = 0;
+		for (i = 0; i < EvalPathNb; i++) SearchCurrent[ThreadId]->eval_nb[i] = 0;
 		SearchCurrent[ThreadId]->time = 0.0;
 		SearchCurrent[ThreadId]->speed = 0.0;
 		SearchCurrent[ThreadId]->cpu = 0.0;
 	}
 }
-#ifdef _WIN32
-void start_suspend_threads(){
 
-   static int ThreadIds[MaxThreads];
-   static unsigned internalThreadIds[MaxThreads];
-   int i;
+// search_init()
 
-   // start and suspend threads
+void search_init() {
 
-   for (i = 1; i < NumberThreads; i++){
-	    ThreadIds[i-1] = i;
-		threat_handle[i-1] = (HANDLE) _beginthreadex( NULL, 0, &search_thread, &ThreadIds[i-1], CREATE_SUSPENDED, &internalThreadIds[i-1]);
-   }
+   // the main thread's state; helpers allocate their own in thread_loop()
+
+   ASSERT(ThreadNb==0);
 
+   thread_alloc(0);
+   ThreadNb = 1;
 }
-void resume_threads(){
 
-   int i;
+// thread_alloc()
 
-   // resume threads
+static void thread_alloc(int ThreadId) {
 
-   for (i = 1; i < NumberThreads; i++){
-	    ResumeThread(threat_handle[i-1]);
-   }
+   void * memory;
+   search_thread_t * thread;
+
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+
+   // 64-byte aligned for the NNUE accumulators, never freed
+
+   memory = my_malloc(sizeof(search_thread_t) + 64);
+   thread = (search_thread_t *) ((uintptr_t(memory) + 63) & ~uintptr_t(63));
+   memset(thread,0,sizeof(search_thread_t));
+
+   SearchInfo[ThreadId] = thread->info;
+   SearchRoot[ThreadId] = thread->root;
+   SearchCurrent[ThreadId] = thread->current;
+   SearchBest[ThreadId] = thread->best;
+
+   sort_alloc(ThreadId);
+   pawn_alloc(ThreadId);
+   material_alloc(ThreadId);
 }
-#else
-void start_suspend_threads(){
 
-   static int ThreadIds[MaxThreads];
-   int i;
+// threads_set()
 
-   // start and suspend threads
+void threads_set(int number) {
 
-   for (i = 1; i < NumberThreads; i++){
-	    ThreadIds[i-1] = i;
-        my_sem_init(&(thread_runnable[i-1]),0);
-	    pthread_create(&(threat_handle[i-1]),NULL,
-			   search_thread,&(ThreadIds[i-1]));
+   int ThreadId;
+
+   if (number < 1) number = 1;
+   if (number > MaxThreads) number = MaxThreads;
+
+   ThreadBind = option_get_bool("NUMA Binding");
+
+   // grow the pool, a thread is never destroyed before exit
+
+   for (ThreadId = ThreadNb; ThreadId < number; ThreadId++) {
+
+      ThreadIds[ThreadId] = ThreadId;
+      my_sem_init(&ThreadWake[ThreadId],0);
+      my_sem_init(&ThreadDone[ThreadId],0);
+
+#ifdef _WIN32
+      ThreadHandle[ThreadId] = (HANDLE) _beginthreadex(NULL,0,&thread_loop,&ThreadIds[ThreadId],0,NULL);
+      if (ThreadHandle[ThreadId] == 0) my_fatal("threads_set(): _beginthreadex() failed\n");
+#else
+      if (pthread_create(&ThreadHandle[ThreadId],NULL,thread_loop,&ThreadIds[ThreadId]) != 0) {
+         my_fatal("threads_set(): pthread_create(): %s\n",strerror(errno));
+      }
+#endif
+
+      my_sem_wait(&ThreadDone[ThreadId]); // state allocated
+
+      ThreadNb = ThreadId + 1;
    }
 
+   NumberThreads = number;
+
+   threads_cache_resize();
 }
-void resume_threads(){
 
-   int i;
-   // resume threads
-   for (i = 1; i < NumberThreads; i++){
-       my_sem_post(&(thread_runnable[i-1]));
-   }
+// threads_cache_resize()
+
+void threads_cache_resize() {
+
+   int ThreadId;
+
+   // the "NNUE Eval Cache" budget is split between the active threads,
+   // sleeping helpers give their share back
+
+   eval_cache_alloc(0);
+
+   for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++) thread_run(ThreadId,JobCache);
+   for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++) my_sem_wait(&ThreadDone[ThreadId]);
+
+   for (ThreadId = NumberThreads; ThreadId < ThreadNb; ThreadId++) eval_cache_free(ThreadId);
 }
+
+// threads_exit()
+
+void threads_exit() {
+
+   int ThreadId;
+
+   // "quit" can arrive in the middle of a search
+
+   for (ThreadId = 1; ThreadId < ThreadNb; ThreadId++) SearchInfo[ThreadId]->stop = true;
+   for (ThreadId = 1; ThreadId < ThreadNb; ThreadId++) thread_run(ThreadId,JobExit);
+
+   for (ThreadId = 1; ThreadId < ThreadNb; ThreadId++) {
+#ifdef _WIN32
+      WaitForSingleObject(ThreadHandle[ThreadId],INFINITE);
+      CloseHandle(ThreadHandle[ThreadId]);
+#else
+      pthread_join(ThreadHandle[ThreadId],NULL);
 #endif
+   }
 
-// exit_threads() 
-
-void exit_threads() {
-  int ThreadId;
-  bool all_exited=false;
-  SearchInput->exit_engine=true; // hack
-  resume_threads();
-  while (!all_exited){
-    all_exited = true;
-    for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++){
-      if (!SearchInfo[ThreadId]->exited)
-	all_exited = false;
-    }
-  }
-  SearchInput->exit_engine=false; // hack
+   ThreadNb = 1;
+   NumberThreads = 1;
 }
 
+// thread_run()
+
+static void thread_run(int ThreadId, int job) {
+
+   ASSERT(ThreadId>=1&&ThreadId<ThreadNb);
+
+   ThreadJob[ThreadId] = job;
+   my_sem_post(&ThreadWake[ThreadId]);
+}
+
+// thread_loop()
+
+#ifdef _WIN32
+static unsigned __stdcall thread_loop(void * param) {
+#else
+static void * thread_loop(void * param) {
+#endif
+
+   int ThreadId;
+   bool done;
+
+   ThreadId = *((int *) param);
+   ASSERT(ThreadId>=1&&ThreadId<MaxThreads);
+
+   // bind before allocating so the thread's memory is node-local;
+   // the main thread (GUI I/O) is left alone and node 0 gets one helper less
+
+   if (ThreadBind) my_numa_bind(ThreadId % my_numa_node_nb());
+
+   thread_alloc(ThreadId);
+   my_sem_post(&ThreadDone[ThreadId]);
+
+   for (done = false; !done; ) {
+
+      my_sem_wait(&ThreadWake[ThreadId]);
+
+      switch (ThreadJob[ThreadId]) {
+      case JobSearch:
+         search_smp(ThreadId);
+         SearchInfo[ThreadId]->stopped = true;
+         break;
+      case JobCache:
+         eval_cache_alloc(ThreadId);
+         break;
+      case JobExit:
+         done = true;
+         break;
+      }
+
+      my_sem_post(&ThreadDone[ThreadId]);
+   }
+
+#ifdef _WIN32
+   _endthreadex(0);
+   return 0;
+#else
+   return NULL;
+#endif
+}
 
 // search()
 
@@ -238,7 +376,6 @@ void search() {
 
    int move;
    int i;
-   bool all_stopped;
    int ThreadId; 
            
    for (i = 0; i < MultiPVMax; i++){
@@ -298,57 +435,19 @@ void search() {
 
    trans_inc_date(Trans);
 
-   // resume threads
+   // start the helpers
 
-   resume_threads();
+   for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++) thread_run(ThreadId,JobSearch);
 
-   //SearchInfo_smp->stop = true;
    search_smp(0);
+
    for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++){ // stop threads
 		SearchInfo[ThreadId]->stop = true;
    }
 
-   all_stopped = false;
-   while (!all_stopped){
-	   all_stopped = true;
-	   for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++){
-			if (!SearchInfo[ThreadId]->stopped)
-				all_stopped = false;
-	   }
-   }
+   for (ThreadId = 1; ThreadId < NumberThreads; ThreadId++) my_sem_wait(&ThreadDone[ThreadId]);
 }
 
-#ifdef _WIN32
-unsigned __stdcall search_thread (void *param) {
-
-	int ThreadId = *((int*)param);
-	SearchInfo[ThreadId]->exited= false;
-
-	while (!SearchInput->exit_engine){
-		search_smp(ThreadId);
-		SearchInfo[ThreadId]->stopped = true;
-		SuspendThread(threat_handle[ThreadId-1]);
-	}
-	SearchInfo[ThreadId]->exited= true;
-	_endthreadex( 0 );
-	return 0;
-}
-#else
-void * search_thread (void *param) {
-
-	int ThreadId = *((int*)param);
-	SearchInfo[ThreadId]->exited= false;
-	my_sem_wait(&(thread_runnable[ThreadId-1]));
-	while (!SearchInput->exit_engine){
-	  search_smp(ThreadId);
-	  SearchInfo[ThreadId]->stopped = true;
-	  my_sem_wait(&(thread_runnable[ThreadId-1]));
-	}
-	SearchInfo[ThreadId]->exited= true;
-	return NULL;
-}
-#endif
-
 // search_smp()
 
 void search_smp(int ThreadId) {
@@ -377,6 +476,7 @@ void search_smp(int ThreadId) {
    // SearchCurrent
 
    board_copy(SearchCurrent[ThreadId]->board,SearchInput->board);
+   board_nnue_attach(SearchCurrent[ThreadId]->board,SearchCurrent[ThreadId]->nnue_stack);
    my_timer_reset(SearchCurrent[ThreadId]->timer);
    my_timer_start(SearchCurrent[ThreadId]->timer);
 
@@ -413,6 +513,7 @@ void search_smp(int ThreadId) {
 			  SearchRoot[ThreadId]->change = false;
 
 			  board_copy(SearchCurrent[ThreadId]->board,SearchInput->board);
+			  board_nnue_attach(SearchCurrent[ThreadId]->board,SearchCurrent[ThreadId]->nnue_stack);
 			  
 			  // Aspiration windows (JD)
 			  
@@ -527,10 +628,17 @@ void search_smp(int ThreadId) {
    }
    else {
 	   for (depth = 1; depth < DepthMax; depth++) {
+
+	      // depth staggering
+
+	      i = (ThreadId - 1) % SkipNb;
+	      if (depth > 1 && ((depth + SkipPhase[i]) / SkipSize[i]) % 2 != 0) continue;
+
 	   	  delta = 16; 
 		  SearchInfo[ThreadId]->can_stop = true;
 		  
 		  board_copy(SearchCurrent[ThreadId]->board,SearchInput->board);
+		  board_nnue_attach(SearchCurrent[ThreadId]->board,SearchCurrent[ThreadId]->nnue_stack);
 
 		  // Aspiration windows
 		  if (depth <= 4){	// Try other values	  
@@ -775,7 +883,7 @@ void search_check(int ThreadId) {
 	if (ThreadId == 0){
 		search_send_stat(ThreadId);
 
-	   if (UseEvent) event();
+	   if (UseEvent && !SearchInput->quiet) event();
 
 	   if (SearchInput->depth_is_limited
 		&& SearchRoot[ThreadId]->depth > SearchInput->depth_limit) {
@@ -11,6 +11,7 @@
 #include "board.h"
 #include "list.h"
 #include "move.h"
+#include "nnue/nnue.h"
 #include "util.h"
 
 // constants
@@ -22,6 +23,8 @@ const int DepthMax = 64;
 const int HeightMax = 256;
 const int HeightNone = -1;
 
+const int NnueStackSize = HeightMax + 2; // + move_is_check()/move_is_legal() probes
+
 const int SearchNormal = 0;
 const int SearchShort  = 1;
 
@@ -57,7 +60,7 @@ struct search_input_t {
    bool depth_is_limited;
    int depth_limit;
    int multipv;
-   volatile bool exit_engine;
+   bool quiet; // bench: no input polling, no output
    bool time_is_limited;
    double time_limit_1;
    double time_limit_2;
@@ -68,7 +71,6 @@ struct search_info_t {
    bool can_stop;
    volatile bool stop;
    volatile bool stopped;
-  volatile bool exited;
    int check_nb;
    int check_inc;
    double last_time;
@@ -96,8 +98,18 @@ struct search_best_t {
    mv_t pv[HeightMax];
 };
 
+// eval() paths, counted per thread for eval_stats()
+
+enum eval_path_t {
+   EvalLazy,      // material+PST estimate was decisive
+   EvalNnue,
+   EvalClassical,
+   EvalPathNb
+};
+
 struct search_current_t {
    board_t board[1];
+   NNUEdata nnue_stack[NnueStackSize];
    my_timer_t timer[1];
    int max_depth;
    int multipv;
@@ -107,18 +119,30 @@ struct search_current_t {
    bool trans_reduction;
    bool do_nullmove;
    sint64 node_nb;
+   sint64 eval_nb[EvalPathNb];
+   bool eval_exact; // last eval() was not a lazy (window dependent) estimate
    double time;
    double speed;
    double cpu;
 };
 
+// everything a thread searches with, allocated once by the thread itself
+// (first touch puts it on the thread's NUMA node) and kept until exit
+
+struct search_thread_t {
+   search_info_t info[1];
+   search_root_t root[1];
+   search_current_t current[1];
+   search_best_t best[MultiPVMax];
+};
+
 // variables
 
 extern search_input_t SearchInput[1];
-extern search_info_t SearchInfo[MaxThreads][1];
-extern search_best_t SearchBest[MaxThreads][MultiPVMax];
-extern search_root_t SearchRoot[MaxThreads][1];
-extern search_current_t SearchCurrent[MaxThreads][1];
+extern search_info_t * SearchInfo[MaxThreads];
+extern search_best_t * SearchBest[MaxThreads];
+extern search_root_t * SearchRoot[MaxThreads];
+extern search_current_t * SearchCurrent[MaxThreads];
 extern int NumberThreads;
 
 // functions
@@ -126,6 +150,7 @@ extern int NumberThreads;
 extern bool depth_is_ok           (int depth);
 extern bool height_is_ok          (int height);
 
+extern void search_init           ();
 extern void search_clear          ();
 extern void search                ();
 extern void search_smp            (int ThreadId);
@@ -136,9 +161,9 @@ extern void search_update_current (int ThreadId);
 
 extern void search_check          (int ThreadId);
 
-extern void start_suspend_threads();
-extern void resume_threads();
-extern void exit_threads();
+extern void threads_set           (int number);
+extern void threads_cache_resize  ();
+extern void threads_exit          ();
 
 #endif // !defined SEARCH_H
 
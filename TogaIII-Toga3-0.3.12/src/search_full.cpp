@@ -116,6 +116,8 @@ static int  full_quiescence      (board_t * board, int alpha, int beta, int dept
 
 static int  full_new_depth       (int depth, int move, board_t * board, bool single_reply, bool in_pv, int height, bool extended, bool * cap_extended, int ThreadId);
 
+static int  full_eval            (board_t * board, int alpha, int beta, int * static_eval, int ThreadId);
+
 static bool do_null              (const board_t * board);
 static bool do_ver               (const board_t * board);
 
@@ -138,7 +140,7 @@ static bool pawn_is_endgame      (int move, const board_t * board);
 void search_full_init(list_t * list, board_t * board, int ThreadId) {
 
    const char * string;
-   int trans_move, trans_depth, trans_flags, trans_value;
+   int trans_move, trans_depth, trans_flags, trans_value, trans_eval;
    int i, j;
    entry_t * found_entry;
 
@@ -224,7 +226,7 @@ void search_full_init(list_t * list, board_t * board, int ThreadId) {
    // basic sort
 
    trans_move = MoveNone;
-   if (UseTrans) trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value);
+   if (UseTrans) trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value,&trans_eval);
    note_moves(list,board,0,trans_move,ThreadId);
    list_sort(list);
 }
@@ -395,6 +397,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    bool single_reply;
    bool good_cap;
    int trans_move, trans_depth, trans_flags, trans_value;
+   int static_eval;
    int old_alpha;
    int value, best_value;
    int move, best_move;
@@ -483,10 +486,11 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    // transposition table
 
    trans_move = MoveNone;
+   static_eval = ValueNone;
 
    if (UseTrans && depth >= TransDepth) {
 
-      	if (trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value)) {
+      	if (trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value,&static_eval)) {
           
 		  	if (node_type != NodePV /*|| ThreadId > 0*/) {
 
@@ -576,7 +580,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    	    if (!(trans_move != MoveNone && !TRANS_IS_LOWER(trans_flags) && trans_value < beta)){
    	    	
    	    	threshold = beta+EvalMargin[depth];
-			value = eval(board,threshold-1, threshold, ThreadId);
+			value = full_eval(board,threshold-1,threshold,&static_eval,ThreadId);
 			   
    	    	if (value >= threshold && value < ValueEvalInf)
    	    		return value;
@@ -597,7 +601,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
       if (!in_check
        && !value_is_mate(beta)
        && do_null(board)
-       && (!UseNullEval || depth <= NullReduction+1 || eval(board,alpha, beta, ThreadId) >= beta)) {
+       && (!UseNullEval || depth <= NullReduction+1 || full_eval(board,alpha,beta,&static_eval,ThreadId) >= beta)) {
 
          // null-move search
          
@@ -632,7 +636,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    
    if (UseRazor && node_type != NodePV && !in_check && trans_move == MoveNone && depth <= RazorDepth){ 
         threshold = alpha - RazorMargin - (depth-1)*39; // Values from Protector (Raimund Heid)
-        if (eval(board,threshold-1, threshold, ThreadId) < threshold){
+        if (full_eval(board,threshold-1,threshold,&static_eval,ThreadId) < threshold){
 		   value = full_quiescence(board,threshold-1,threshold,0,height,pv,ThreadId); 
            if (value < threshold) return value;
         }
@@ -831,7 +835,7 @@ cut:
       if (best_value < beta) trans_flags |= TransUpper;
       trans_value = value_to_trans(best_value,height);
 
-      trans_store(Trans,board->key,trans_move,trans_depth,trans_flags,trans_value);
+      trans_store(Trans,board->key,trans_move,trans_depth,trans_flags,trans_value,static_eval);
 
    }
 
@@ -853,6 +857,7 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
    undo_t undo[1];
    mv_t new_pv[HeightMax];
    int trans_move, trans_depth, trans_flags, trans_value;
+   int static_eval;
    entry_t * found_entry;
 
    ASSERT(board!=NULL);
@@ -911,10 +916,11 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
    // new in Toga II 4.0: accept hash hits in PV ~ +3 elo
    
    trans_move = MoveNone;
+   static_eval = ValueNone;
    
    if (UseTrans) { 
 
-      if (trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value)) {
+      if (trans_retrieve(Trans,&found_entry,board->key,&trans_move,&trans_depth,&trans_flags,&trans_value,&static_eval)) {
 
 		 trans_value = value_from_trans(trans_value,height);
 
@@ -956,7 +962,7 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
       // stand pat
 
-      value = eval(board, alpha, beta, ThreadId);
+      value = full_eval(board,alpha,beta,&static_eval,ThreadId);
       
       // see if hash can be used to improve the evaluation estimate
       if (trans_move != MoveNone && trans_value != ValueNone){
@@ -1056,7 +1062,7 @@ cut:
       if (best_value < beta) trans_flags |= TransUpper;
       trans_value = value_to_trans(best_value,height);
 
-      trans_store(Trans,board->key,trans_move,trans_depth,trans_flags,trans_value);
+      trans_store(Trans,board->key,trans_move,trans_depth,trans_flags,trans_value,static_eval);
 
    }
 
@@ -1168,10 +1174,32 @@ static void pv_fill(const mv_t pv[], board_t * board) {
       trans_move = move;
       trans_depth = -127; // HACK
       
-      trans_store(Trans,board->key,trans_move,trans_depth,TransUnknown,-ValueInf);
+      trans_store(Trans,board->key,trans_move,trans_depth,TransUnknown,-ValueInf,ValueNone);
    }
 }
 
+// full_eval()
+
+static int full_eval(board_t * board, int alpha, int beta, int * static_eval, int ThreadId) {
+
+   int value;
+
+   ASSERT(board!=NULL);
+   ASSERT(range_is_ok(alpha,beta));
+   ASSERT(static_eval!=NULL);
+
+   // the static eval from the hash table (or an earlier call at this node)
+   // saves a full NNUE evaluation
+
+   if (*static_eval != ValueNone) return *static_eval;
+
+   value = eval(board,alpha,beta,ThreadId);
+
+   if (SearchCurrent[ThreadId]->eval_exact) *static_eval = value;
+
+   return value;
+}
+
 // move_is_dangerous()
 
 static bool move_is_dangerous(int move, const board_t * board) {
@@ -3,6 +3,8 @@
 
 // includes
 
+#include <cstring>
+
 #include "attack.h"
 #include "board.h"
 #include "colour.h"
@@ -78,12 +80,17 @@ static int PosCaptureQS;
 
 static int Code[CODE_SIZE];
 
-static uint16 Killer[MaxThreads][HeightMax][KillerNb];
-static uint16 Refutation[MaxThreads][12][64][64];
+// move-ordering tables, one block per thread allocated by sort_alloc()
+
+struct sort_table_t {
+   uint16 killer[HeightMax][KillerNb];
+   uint16 refutation[12][64][64];
+   sint16 history[HistorySize];
+   uint16 hist_hit[HistorySize];
+   uint16 hist_tot[HistorySize];
+};
 
-static sint16 History[MaxThreads][HistorySize];
-static uint16 HistHit[MaxThreads][HistorySize];
-static uint16 HistTot[MaxThreads][HistorySize];
+static sort_table_t * SortTable[MaxThreads];
 
 // prototypes
 
@@ -107,6 +114,17 @@ static uint16  history_index  (int move, const board_t * board);
 
 // functions
 
+// sort_alloc()
+
+void sort_alloc(int ThreadId) {
+
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+   ASSERT(SortTable[ThreadId]==NULL);
+
+   SortTable[ThreadId] = (sort_table_t *) my_malloc(sizeof(sort_table_t));
+   memset(SortTable[ThreadId],0,sizeof(sort_table_t));
+}
+
 // sort_init()
 
 void sort_init(int ThreadId) {
@@ -118,25 +136,25 @@ void sort_init(int ThreadId) {
    // killer
 
    for (height = 0; height < HeightMax; height++) {
-      for (i = 0; i < KillerNb; i++) Killer[ThreadId][height][i] = MoveNone;
+      for (i = 0; i < KillerNb; i++) SortTable[ThreadId]->killer[height][i] = MoveNone;
    }
    
    // refutation table
    
    for (i = 0; i < 12; i++) {
       for (j = 0; j < 64; j++){
-      	for (k = 0; k < 64; k++)Refutation[ThreadId][i][j][k] = MoveNone;
+      	for (k = 0; k < 64; k++)SortTable[ThreadId]->refutation[i][j][k] = MoveNone;
       } 
    }
 
    // history
 
-   for (i = 0; i < HistorySize; i++) History[ThreadId][i] = 0;
+   for (i = 0; i < HistorySize; i++) SortTable[ThreadId]->history[i] = 0;
 
    //if (first_time){
 	   for (i = 0; i < HistorySize; i++) {
-		  HistHit[ThreadId][i] = 1;
-		  HistTot[ThreadId][i] = 1;
+		  SortTable[ThreadId]->hist_hit[i] = 1;
+		  SortTable[ThreadId]->hist_tot[i] = 1;
 	   }
 	//   first_time = false;
    //}
@@ -209,9 +227,12 @@ void sort_init(sort_t * sort, board_t * board, const attack_t * attack, int dept
    sort->capture_nb = 0;
 
    sort->trans_killer = trans_killer;
-   sort->killer_1 = Killer[ThreadId][sort->height][0];
-   sort->killer_2 = Killer[ThreadId][sort->height][1];
-   sort->refutation_move = Refutation[ThreadId][piece][from_64][to_64];
+   sort->killer_1 = SortTable[ThreadId]->killer[sort->height][0];
+   sort->killer_2 = SortTable[ThreadId]->killer[sort->height][1];
+   sort->refutation_move = MoveNone;
+   if (piece >= 0) { // last_move can be stale (empty "to" square), the table has no slack around it
+      sort->refutation_move = SortTable[ThreadId]->refutation[piece][from_64][to_64];
+   }
    
    if (ATTACK_IN_CHECK(sort->attack)) {
 
@@ -515,23 +536,23 @@ void good_move(int move, const board_t * board, int depth, int height, int Threa
 
    // killer
 
-   if (Killer[ThreadId][height][0] != move) {
-      Killer[ThreadId][height][1] = Killer[ThreadId][height][0];
-      Killer[ThreadId][height][0] = move;
+   if (SortTable[ThreadId]->killer[height][0] != move) {
+      SortTable[ThreadId]->killer[height][1] = SortTable[ThreadId]->killer[height][0];
+      SortTable[ThreadId]->killer[height][0] = move;
    }
 
-   ASSERT(Killer[ThreadId][height][0]==move);
-   ASSERT(Killer[ThreadId][height][1]!=move);
+   ASSERT(SortTable[ThreadId]->killer[height][0]==move);
+   ASSERT(SortTable[ThreadId]->killer[height][1]!=move);
    
    // history
 
    index = history_index(move,board);
 
-   History[ThreadId][index] += HISTORY_INC(depth);
+   SortTable[ThreadId]->history[index] += HISTORY_INC(depth);
 
-   if (History[ThreadId][index] >= HistoryMax) {
+   if (SortTable[ThreadId]->history[index] >= HistoryMax) {
       for (i = 0; i < HistorySize; i++) {
-         History[ThreadId][i] = (History[ThreadId][i] + 1) / 2;
+         SortTable[ThreadId]->history[i] = (SortTable[ThreadId]->history[i] + 1) / 2;
       }
    } 
 }
@@ -554,11 +575,11 @@ void bad_move(int move, const board_t * board, int depth, int height, int Thread
 
    index = history_index(move,board);
 
-   History[ThreadId][index] -= depth;
+   SortTable[ThreadId]->history[index] -= depth;
 
-   if (History[ThreadId][index] >= HistoryMax) {
+   if (SortTable[ThreadId]->history[index] >= HistoryMax) {
       for (i = 0; i < HistorySize; i++) {
-         History[ThreadId][i] = (History[ThreadId][i] + 1) / 2;
+         SortTable[ThreadId]->history[i] = (SortTable[ThreadId]->history[i] + 1) / 2;
       }
    } 
 }
@@ -583,9 +604,11 @@ void refutation_update(int best_move, int last_move, const board_t * board, int
 
    //if (move_is_tactical(move,board)) return;
 
+   if (piece < 0) return; // stale last_move, see sort_init()
+
    // refutation
 
-   Refutation[ThreadId][piece][from_64][to_64] = best_move;
+   SortTable[ThreadId]->refutation[piece][from_64][to_64] = best_move;
    
 }
    
@@ -605,16 +628,16 @@ void history_good(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   HistHit[ThreadId][index]++;
-   HistTot[ThreadId][index]++;
+   SortTable[ThreadId]->hist_hit[index]++;
+   SortTable[ThreadId]->hist_tot[index]++;
    
-   if (HistTot[ThreadId][index] >= HistoryMax) {
-      HistHit[ThreadId][index] = (HistHit[ThreadId][index] + 1) / 2;
-      HistTot[ThreadId][index] = (HistTot[ThreadId][index] + 1) / 2;
+   if (SortTable[ThreadId]->hist_tot[index] >= HistoryMax) {
+      SortTable[ThreadId]->hist_hit[index] = (SortTable[ThreadId]->hist_hit[index] + 1) / 2;
+      SortTable[ThreadId]->hist_tot[index] = (SortTable[ThreadId]->hist_tot[index] + 1) / 2;
    }
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   ASSERT(SortTable[ThreadId]->hist_hit[index]<=SortTable[ThreadId]->hist_tot[index]);
+   ASSERT(SortTable[ThreadId]->hist_tot[index]<HistoryMax);
 }
 
 // history_bad()
@@ -632,15 +655,15 @@ void history_bad(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   HistTot[ThreadId][index]++;
+   SortTable[ThreadId]->hist_tot[index]++;
    
-   if (HistTot[ThreadId][index] >= HistoryMax) {
-      HistHit[ThreadId][index] = (HistHit[ThreadId][index] + 1) / 2;
-      HistTot[ThreadId][index] = (HistTot[ThreadId][index] + 1) / 2;
+   if (SortTable[ThreadId]->hist_tot[index] >= HistoryMax) {
+      SortTable[ThreadId]->hist_hit[index] = (SortTable[ThreadId]->hist_hit[index] + 1) / 2;
+      SortTable[ThreadId]->hist_tot[index] = (SortTable[ThreadId]->hist_tot[index] + 1) / 2;
    }
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   ASSERT(SortTable[ThreadId]->hist_hit[index]<=SortTable[ThreadId]->hist_tot[index]);
+   ASSERT(SortTable[ThreadId]->hist_tot[index]<HistoryMax);
 }
 
 void history_reset(int move, const board_t * board, int ThreadId) {
@@ -654,11 +677,11 @@ void history_reset(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   HistHit[ThreadId][index] = 1; //HistHit[ThreadId][index]/3 + 1;
-   HistTot[ThreadId][index] = 1; //HistHit[ThreadId][index]/2 + 1;
+   SortTable[ThreadId]->hist_hit[index] = 1; //SortTable[ThreadId]->hist_hit[index]/3 + 1;
+   SortTable[ThreadId]->hist_tot[index] = 1; //SortTable[ThreadId]->hist_hit[index]/2 + 1;
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   ASSERT(SortTable[ThreadId]->hist_hit[index]<=SortTable[ThreadId]->hist_tot[index]);
+   ASSERT(SortTable[ThreadId]->hist_tot[index]<HistoryMax);
 }
 
 // note_moves()
@@ -779,9 +802,9 @@ static int move_value(int move, const board_t * board, int height, int trans_kil
       value = TransScore;
    } else if (move_is_tactical(move,board)) { // capture or promote
       value = capture_value(move,board);
-   } else if (move == Killer[ThreadId][height][0]) { // killer 1
+   } else if (move == SortTable[ThreadId]->killer[height][0]) { // killer 1
       value = KillerScore;
-   } else if (move == Killer[ThreadId][height][1]) { // killer 2
+   } else if (move == SortTable[ThreadId]->killer[height][1]) { // killer 2
       value = KillerScore - 2;
    } else { // quiet move
       value = quiet_move_value(move,board,ThreadId);
@@ -828,7 +851,7 @@ static int quiet_move_value(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   value = HistoryScore + History[ThreadId][index];
+   value = HistoryScore + SortTable[ThreadId]->history[index];
    ASSERT(value>=HistoryScore&&value<=KillerScore-4);
 
    return value;
@@ -863,10 +886,10 @@ static int history_prob(int move, const board_t * board, int ThreadId) {
 
    index = history_index(move,board);
 
-   ASSERT(HistHit[ThreadId][index]<=HistTot[ThreadId][index]);
-   ASSERT(HistTot[ThreadId][index]<HistoryMax);
+   ASSERT(SortTable[ThreadId]->hist_hit[index]<=SortTable[ThreadId]->hist_tot[index]);
+   ASSERT(SortTable[ThreadId]->hist_tot[index]<HistoryMax);
 
-   value = (HistHit[ThreadId][index] * 16384) / HistTot[ThreadId][index];
+   value = (SortTable[ThreadId]->hist_hit[index] * 16384) / SortTable[ThreadId]->hist_tot[index];
    
    ASSERT(value>=0&&value<=16384);
 
@@ -34,6 +34,7 @@ struct sort_t {
 
 // functions
 
+extern void sort_alloc   (int ThreadId);
 extern void sort_init    (int ThreadId);
 
 extern void sort_init    (sort_t * sort, board_t * board, const attack_t * attack, int depth, int height, int trans_killer, int last_move, int ThreadId);
@@ -3,6 +3,8 @@
 
 // includes
 
+#include <cstddef>
+
 #include "hash.h"
 #include "move.h"
 #include "option.h"
@@ -19,14 +21,13 @@
 #define ENTRY_DATE(entry)  ((entry)->date_flags>>4)
 #define ENTRY_FLAGS(entry) ((entry)->date_flags&TransFlags)
 
-
 // constants
 
 static const bool UseModulo = false;
 
 static const int DateSize = 16;
 
-static const int ClusterSize = 4; // TODO: unsigned?
+static const int ClusterSize = 4; // 4 * 12 bytes + padding = one cache line
 
 static const bool AlwaysWrite = true; //was true
 
@@ -61,10 +62,18 @@ static const int DepthNone = -128;
    uint16 nproc; 
 };*/
 
+// entries hold the upper 32 bits of the key, the lower ones select the cluster
+
+struct cluster_t {
+   entry_t entry[ClusterSize];
+   uint32 pad[4];
+};
+
 struct trans { // HACK: typedef'ed in trans.h
-   entry_t * table;
-   uint32 size;
-   uint32 mask;
+   cluster_t * table; // 64-byte aligned
+   void * memory;
+   uint32 size; // entries
+   uint32 mask; // clusters - 1
    int date;
    int age[DateSize];
    uint32 used;
@@ -116,11 +125,13 @@ void trans_init(trans_t * trans) {
 
    ASSERT(trans!=NULL);
 
-   ASSERT(sizeof(entry_t)==16);
+   ASSERT(sizeof(entry_t)==12);
+   ASSERT(sizeof(cluster_t)==64);
 
    trans->size = 0;
    trans->mask = 0;
    trans->table = NULL;
+   trans->memory = NULL;
 
    trans_set_date(trans,0);
 
@@ -148,13 +159,14 @@ void trans_alloc(trans_t * trans) {
 
    // allocate table
 
-   size /= sizeof(entry_t);
+   size /= sizeof(cluster_t);
    ASSERT(size!=0&&(size&(size-1))==0); // power of 2
 
-   trans->size = (uint32) size + (ClusterSize - 1); // HACK to avoid testing for end of table
+   trans->size = (uint32) size * ClusterSize;
    trans->mask = (uint32) size - 1;
 
-   trans->table = (entry_t *)my_malloc(Trans->size*sizeof(entry_t));
+   trans->memory = my_malloc(size*sizeof(cluster_t)+64);
+   trans->table = (cluster_t *) ((size_t(trans->memory) + 63) & ~size_t(63));
 
    trans_clear(trans);
 
@@ -167,9 +179,10 @@ void trans_free(trans_t * trans) {
 
    ASSERT(trans_is_ok(trans));
 
-   my_free(trans->table);
+   my_free(trans->memory);
 
    trans->table = NULL;
+   trans->memory = NULL;
    trans->size = 0;
    trans->mask = 0;
 }
@@ -181,22 +194,28 @@ void trans_clear(trans_t * trans) {
    entry_t clear_entry[1];
    entry_t * entry;
    uint32 index;
+   int i;
 
    ASSERT(trans!=NULL);
 
    trans_set_date(trans,0);
 
-   clear_entry->key = 0;
+   clear_entry->lock = 0;
    clear_entry->move = MoveNone;
    clear_entry->depth = DepthNone;
    clear_entry->date_flags = (trans->date << 4);
+   clear_entry->value = 0;
+   clear_entry->eval = ValueNone;
       
    ASSERT(entry_is_ok(clear_entry));
 
-   entry = trans->table;
+   if (trans->table == NULL) return;
 
-   for (index = 0; index < trans->size; index++) {
-      *entry++ = *clear_entry;
+   for (index = 0; index <= trans->mask; index++) {
+      entry = trans->table[index].entry;
+      for (i = 0; i < ClusterSize; i++) {
+         *entry++ = *clear_entry;
+      }
    }
 }
 
@@ -249,22 +268,26 @@ static int trans_age(const trans_t * trans, int date) {
 
 // trans_store()
 
-void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, int value) {
+void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, int value, int eval) {
 
    entry_t * entry, * best_entry;
    int score, best_score;
    int i;
+   uint32 lock;
 
    ASSERT(trans_is_ok(trans));
    ASSERT(move>=0&&move<65536);
    ASSERT(depth>=0&&depth<256);
    ASSERT((flags&~TransFlags)==0);
    ASSERT(value>=-32767&&value<=+32767);
+   ASSERT(eval>=-32767&&eval<=+32767);
    
    // init
 
    trans->write_nb++;
 
+   lock = KEY_LOCK(key);
+
    // probe
 
    best_entry = NULL;
@@ -274,13 +297,15 @@ void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, in
 
    for (i = 0; i < ClusterSize; i++, entry++) {
 
-      if (entry->key == key) {
+      if (entry->lock == lock) {
 
          // hash hit => update existing entry
 
          trans->write_hit++;
          if (ENTRY_DATE(entry) != trans->date) trans->used++;
 
+         if (eval != ValueNone) entry->eval = eval;
+
          if (entry->depth <= depth) {
 
             if (SmartMove && move == MoveNone) move = entry->move;
@@ -288,7 +313,7 @@ void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, in
                flags |= ENTRY_FLAGS(entry); // HACK
             }
 
-            ASSERT(entry->key==key);
+            ASSERT(entry->lock==lock);
             entry->move = move;
             entry->depth = depth;
             entry->date_flags = (trans->date << 4) | flags;
@@ -322,7 +347,7 @@ void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, in
 
    entry = best_entry;
    ASSERT(entry!=NULL);
-   ASSERT(entry->key!=key);
+   ASSERT(entry->lock!=lock);
 
    if (ENTRY_DATE(entry) == trans->date) {
 
@@ -341,11 +366,12 @@ void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, in
 
    ASSERT(entry!=NULL);
 
-   entry->key = key;
+   entry->lock = lock;
    entry->move = move;
    entry->depth = depth;
    entry->date_flags = (trans->date << 4) | flags;
    entry->value = value;
+   entry->eval = eval;
    // entry->size = node_nb; // TODO: 64->16 mapping
 
 }
@@ -353,28 +379,32 @@ void trans_store(trans_t * trans, uint64 key, int move, int depth, int flags, in
 
 // trans_retrieve()
 
-bool trans_retrieve(trans_t * trans, entry_t ** found_entry, uint64 key, int * move, int * depth, int * flags, int * value) {
+bool trans_retrieve(trans_t * trans, entry_t ** found_entry, uint64 key, int * move, int * depth, int * flags, int * value, int * eval) {
 
    int i;
    entry_t * entry;
+   uint32 lock;
 
    ASSERT(trans_is_ok(trans));
    ASSERT(move!=NULL);
    ASSERT(depth!=NULL);
    ASSERT(flags!=NULL);
    ASSERT(value!=NULL);
+   ASSERT(eval!=NULL);
 
    // init
 
    trans->read_nb++;
 
+   lock = KEY_LOCK(key);
+
    // probe
 
    entry = trans_entry(trans,key);
 
    for (i = 0; i < ClusterSize; i++, entry++) {
 
-      if (entry->key == key) {
+      if (entry->lock == lock) {
 
          // found
 
@@ -384,6 +414,7 @@ bool trans_retrieve(trans_t * trans, entry_t ** found_entry, uint64 key, int * m
          *depth = entry->depth;
          *flags = ENTRY_FLAGS(entry);
          *value = entry->value;
+         *eval  = entry->eval;
 
 		 *found_entry = entry;
          return true;
@@ -392,6 +423,8 @@ bool trans_retrieve(trans_t * trans, entry_t ** found_entry, uint64 key, int * m
 
    // not found
 
+   *eval = ValueNone;
+
    *found_entry = entry;
    return false;
 }
@@ -421,14 +454,14 @@ static entry_t * trans_entry(trans_t * trans, uint64 key) {
    ASSERT(trans_is_ok(trans));
 
    if (UseModulo) {
-      index = key % (trans->mask + 1);
+      index = KEY_INDEX(key) % (trans->mask + 1);
    } else {
-      index = key & trans->mask;
+      index = KEY_INDEX(key) & trans->mask;
    }
 
    ASSERT(index<=trans->mask);
 
-   return &trans->table[index];
+   return trans->table[index].entry;
 }
 
 // entry_is_ok()
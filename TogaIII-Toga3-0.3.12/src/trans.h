@@ -26,12 +26,12 @@ const int TransFlags   = 3;
 #define TRANS_IS_EXACT(flags) ((flags)==TransExact)
 
 struct entry_t {
-   uint64 key;
+   uint32 lock;
    uint16 move;
    uint8 depth;
    uint8 date_flags;
    sint16 value;
-   uint16 nproc; 
+   sint16 eval; // static eval, ValueNone if unknown
 };
 
 // types
@@ -54,8 +54,8 @@ extern void trans_free     (trans_t * trans);
 extern void trans_clear    (trans_t * trans);
 extern void trans_inc_date (trans_t * trans);
 
-extern void trans_store    (trans_t * trans, uint64 key, int move, int depth, int flags, int value);
-extern bool trans_retrieve (trans_t * trans, entry_t ** found_entry, uint64 key, int * move, int * depth, int * flags, int * value);
+extern void trans_store    (trans_t * trans, uint64 key, int move, int depth, int flags, int value, int eval);
+extern bool trans_retrieve (trans_t * trans, entry_t ** found_entry, uint64 key, int * move, int * depth, int * flags, int * value, int * eval);
 
 extern void trans_stats    (const trans_t * trans);
 
@@ -12,6 +12,12 @@
 #include <cstring>
 #include <ctime>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "posix.h"
 #include "util.h"
 
@@ -325,8 +331,110 @@ void my_sem_wait(my_sem_t *sem){
     sem->value--;
     pthread_mutex_unlock(&(sem->mutex));
 }
+
+#else
+
+// my_sem_init()
+
+void my_sem_init(my_sem_t *sem, int value){
+    *sem = CreateSemaphore(NULL,value,0x7FFFFFFF,NULL);
+    if (*sem == NULL) my_fatal("my_sem_init(): CreateSemaphore() failed\n");
+}
+
+// my_sem_post()
+
+void my_sem_post(my_sem_t *sem){
+    ReleaseSemaphore(*sem,1,NULL);
+}
+
+// my_sem_wait()
+
+void my_sem_wait(my_sem_t *sem){
+    WaitForSingleObject(*sem,INFINITE);
+}
 #endif
 
+// NUMA placement. Only Linux is handled (the node layout is read from sysfs,
+// no libnuma needed); elsewhere the machine is reported as a single node and
+// threads are left to the OS scheduler.
+
+#ifdef __linux__
+
+static const int NumaNodeMax = 64;
+
+static int NumaNodeNb = -1;
+static cpu_set_t NumaCpus[NumaNodeMax];
+
+// numa_read_cpulist()
+
+static bool numa_read_cpulist(int node, cpu_set_t * cpus) {
+
+   char name[256], string[4096];
+   FILE * file;
+   const char * ptr;
+   char * end;
+   long first, last, cpu;
+
+   sprintf(name,"/sys/devices/system/node/node%d/cpulist",node);
+
+   file = fopen(name,"r");
+   if (file == NULL) return false;
+   if (!my_file_read_line(file,string,sizeof(string))) string[0] = '\0';
+   fclose(file);
+
+   // "0-7,16-23"
+
+   CPU_ZERO(cpus);
+
+   for (ptr = string; *ptr != '\0'; ptr = end) {
+      first = strtol(ptr,&end,10);
+      if (end == ptr) break;
+      last = first;
+      if (*end == '-') last = strtol(end+1,&end,10);
+      for (cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu,cpus);
+      if (*end == ',') end++;
+   }
+
+   return CPU_COUNT(cpus) != 0;
+}
+
+#endif
+
+// my_numa_node_nb()
+
+int my_numa_node_nb() {
+
+#ifdef __linux__
+
+   if (NumaNodeNb < 0) {
+      for (NumaNodeNb = 0; NumaNodeNb < NumaNodeMax; NumaNodeNb++) {
+         if (!numa_read_cpulist(NumaNodeNb,&NumaCpus[NumaNodeNb])) break;
+      }
+      if (NumaNodeNb == 0) NumaNodeNb = 1; // no sysfs: one node, never bound
+   }
+
+   return NumaNodeNb;
+#else
+   return 1;
+#endif
+}
+
+// my_numa_bind()
+
+bool my_numa_bind(int node) {
+
+#ifdef __linux__
+
+   if (my_numa_node_nb() <= 1) return false;
+
+   ASSERT(node>=0&&node<NumaNodeNb);
+
+   return sched_setaffinity(0,sizeof(cpu_set_t),&NumaCpus[node]) == 0;
+#else
+   return false;
+#endif
+}
+
 
 
 // end of util.cpp
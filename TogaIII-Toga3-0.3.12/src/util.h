@@ -94,6 +94,8 @@ typedef struct {
     pthread_mutex_t mutex;
     pthread_cond_t cond;
 } my_sem_t;
+#else
+typedef void * my_sem_t; // HANDLE of a Win32 semaphore
 #endif
 
 struct my_timer_t {
@@ -137,11 +139,12 @@ extern double my_timer_elapsed_real (const my_timer_t * timer);
 extern double my_timer_elapsed_cpu  (const my_timer_t * timer);
 extern double my_timer_cpu_usage    (const my_timer_t * timer);
 
-#ifndef _WIN32
 extern void my_sem_init(my_sem_t *sem, int value);
 extern void my_sem_post(my_sem_t *sem);
 extern void my_sem_wait(my_sem_t *sem);
-#endif
+
+extern int    my_numa_node_nb       ();
+extern bool   my_numa_bind          (int node);
 
 #endif // !defined UTIL_H
 
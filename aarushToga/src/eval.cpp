@@ -4,7 +4,7 @@
 // includes
 
 #include <cstdlib> // for abs()
-#include "king_activity.h"
+
 #include "attack.h"
 #include "board.h"
 #include "colour.h"
@@ -441,13 +441,7 @@ int eval(board_t * board, int alpha, int beta, int ThreadId) {
    // eval
 
    eval_king(board,mat_info,&opening,&endgame);
-   // Evaluate king activity for White
-int king_activity_white = evaluate_king_activity(board, White);
-opening += king_activity_white; // Add the score to the opening phase
-
-// Evaluate king activity for Black
-int king_activity_black = evaluate_king_activity(board, Black);
-opening -= king_activity_black; // Subtract the score for Black (opposite colour)
+   // king activity is a piece-square term (king_activity.cpp), already in board->opening/endgame
    eval_passer(board,pawn_info,&opening,&endgame);
    
    // 2nd Lazy Eval Cutoff JD 
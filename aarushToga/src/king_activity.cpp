@@ -1,22 +1,31 @@
-#include "board.h"
+#include "king_activity.h"
+#include "piece.h"
+#include "pst.h"
 #include "util.h"
 
-// King activity scoring function
-int evaluate_king_activity(const board_t *board, int colour) {
-    int king = KING_POS(board, colour); // King's current position
-    int phase = board->phase;          // Game phase
-    int score = 0;
+// King activity depends on the king's square and the game phase only, so
+// it is a piece-square term: board->opening/endgame carry it through
+// move_do()/move_undo() and eval() does not recompute it at every leaf.
 
-    if (phase < 128) { // Endgame phase
-        score += 14 - DISTANCE(king, CENTER_SQUARE); // Bonus for central king
-    } else { // Opening and Middlegame
-        if (SQUARE_FILE(king) == FileA || SQUARE_FILE(king) == FileH) {
-            score -= 20; // Penalty for king on the edge
-        }
-        if (SQUARE_RANK(king) == Rank1 || SQUARE_RANK(king) == Rank8) {
-            score -= 10; // Penalty for king on the back rank
-        }
+static void king_activity_term(int square_64, int *opening, int *endgame) {
+    int file = square_64 & 7;
+    int rank = square_64 >> 3;
+    int file_distance = (file < 4) ? 3 - file : file - 4; // to the d/e files
+    int rank_distance = (rank < 4) ? 3 - rank : rank - 4; // to the 4th/5th ranks
+
+    // Endgame: bonus for a central king
+    *endgame += 14 - ((file_distance > rank_distance) ? file_distance : rank_distance);
+
+    // Opening and middlegame: penalties for a king on the edge or the back rank
+    if (file == 0 || file == 7) {
+        *opening -= 20;
     }
+    if (rank == 0 || rank == 7) {
+        *opening -= 10;
+    }
+}
 
-    return score;
+// Register the term, before pst_init() builds the tables
+void king_activity_init() {
+    pst_register(WhiteKing12, king_activity_term);
 }
@@ -1,9 +1,7 @@
 #ifndef KING_ACTIVITY_H
 #define KING_ACTIVITY_H
 
-#include "board.h"
-
-// Function to evaluate king activity
-int evaluate_king_activity(const board_t *board, int colour);
+// Register the king activity piece-square term
+void king_activity_init();
 
 #endif // KING_ACTIVITY_H
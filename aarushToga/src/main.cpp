@@ -9,12 +9,14 @@
 #include "attack.h"
 #include "book.h"
 #include "hash.h"
+#include "king_activity.h"
 #include "move_do.h"
 #include "option.h"
 #include "pawn.h"
 #include "piece.h"
 #include "protocol.h"
 #include "random.h"
+#include "search.h"
 #include "square.h"
 #include "trans.h"
 #include "util.h"
@@ -46,6 +48,7 @@ int main(int argc, char * argv[]) {
    vector_init();
    attack_init();
    move_do_init();
+   king_activity_init(); // before pst_init()
 
    random_init();
    
@@ -54,6 +57,8 @@ int main(int argc, char * argv[]) {
    
    book_init();
 
+   search_alloc(); // thread 0, the others once "Number of Threads" is known
+
    // loop
 
    loop();
@@ -7,12 +7,14 @@
 #include "board.h"
 #include "colour.h"
 #include "hash.h"
+#include "material.h"
 #include "move.h"
 #include "move_do.h"
 #include "pawn.h" // TODO: bit.h
 #include "piece.h"
 #include "pst.h"
 #include "random.h"
+#include "trans.h"
 #include "util.h"
 #include "value.h"
 
@@ -213,6 +215,12 @@ void move_do(board_t * board, int move, undo_t * undo) {
       }
    }
 
+   // prefetch the hash entries of the new position, eval and the next probe come soon
+
+   trans_prefetch(Trans,board->key);
+   if (board->pawn_key != undo->pawn_key) pawn_prefetch(board->pawn_key,board->thread);
+   if (board->material_key != undo->material_key) material_prefetch(board->material_key,board->thread);
+
    // debug
 
    ASSERT(board_is_ok(board));
@@ -363,6 +371,10 @@ void move_do_null(board_t * board, undo_t * undo) {
    board->cap_sq = SquareNone;
 	board->moving_piece = PieceNone256;
 
+   // prefetch the hash entry of the new position
+
+   trans_prefetch(Trans,board->key);
+
    // debug
 
    ASSERT(board_is_ok(board));
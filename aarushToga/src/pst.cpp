@@ -86,10 +86,16 @@ static const int KingRank[8] = {
    +1, +0, -2, -3, -4, -5, -6, -7,
 };
 
+static const int TermMax = 16;
+
 // variables
 
 sint16 Pst[12][64][StageNb];
 
+static int TermNb = 0;
+static int TermPiece[TermMax];
+static pst_term_t Term[TermMax];
+
 // prototypes
 
 static int square_make (int file, int rank);
@@ -116,6 +122,7 @@ void pst_init() {
 
    int i;
    int piece, sq, stage;
+   int opening, endgame;
 
    // UCI options
 
@@ -303,6 +310,21 @@ void pst_init() {
       P(piece,sq,Endgame) = (P(piece,sq,Endgame) * PieceSquareWeight) / 256;
    }
 
+   // registered terms, move_do() then keeps them up to date with the rest
+
+   for (i = 0; i < TermNb; i++) {
+
+      piece = TermPiece[i];
+
+      for (sq = 0; sq < 64; sq++) {
+         opening = 0;
+         endgame = 0;
+         (*Term[i])(sq,&opening,&endgame);
+         P(piece,sq,Opening) += opening;
+         P(piece,sq,Endgame) += endgame;
+      }
+   }
+
    // symmetry copy for black
 
    for (piece = 0; piece < 12; piece += 2) { // HACK
@@ -314,6 +336,29 @@ void pst_init() {
    }
 }
 
+// pst_register()
+
+void pst_register(int piece_12, pst_term_t term) {
+
+   int i;
+
+   ASSERT(piece_12>=0&&piece_12<12);
+   ASSERT((piece_12&1)==0); // white piece, black is the symmetry copy
+   ASSERT(term!=NULL);
+
+   // terms of the piece square and the game phase only, applied by pst_init()
+
+   for (i = 0; i < TermNb; i++) {
+      if (TermPiece[i] == piece_12 && Term[i] == term) return;
+   }
+
+   if (TermNb >= TermMax) my_fatal("pst_register(): too many terms\n");
+
+   TermPiece[TermNb] = piece_12;
+   Term[TermNb] = term;
+   TermNb++;
+}
+
 // square_make()
 
 static int square_make(int file, int rank) {
@@ -18,6 +18,10 @@ const int StageNb = 2;
 
 #define PST(piece_12,square_64,stage) (Pst[piece_12][square_64][stage])
 
+// types
+
+typedef void (*pst_term_t) (int square_64, int * opening, int * endgame); // white's point of view
+
 // variables
 
 extern sint16 Pst[12][64][StageNb];
@@ -27,6 +31,8 @@ extern sint16 Pst[12][64][StageNb];
 extern void pst_init ();
 extern void pst_parameter ();
 
+extern void pst_register (int piece_12, pst_term_t term);
+
 #endif // !defined PST_H
 
 // end of pst.h
@@ -17,7 +17,9 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <istream>
 #include <vector>
@@ -127,6 +129,13 @@ void benchmark(const Position& current, istream& is) {
       file.close();
   }
 
+  for (size_t i = 0; i < Threads.size(); ++i)
+  {
+      Threads[i]->pawnsTable.probes = Threads[i]->materialTable.probes = 0;
+      Threads[i]->pawnsTable.hits = Threads[i]->materialTable.hits = 0;
+      Threads[i]->pawnsTable.sharedHits = Threads[i]->materialTable.sharedHits = 0;
+  }
+
   uint64_t nodes = 0;
   Search::StateStackPtr st;
   Time::point elapsed = Time::now();
@@ -169,4 +178,28 @@ void benchmark(const Position& current, istream& is) {
        << "\nTotal time (ms) : " << elapsed
        << "\nNodes searched  : " << nodes
        << "\nNodes/second    : " << 1000 * nodes / elapsed << endl;
+
+  // Where the pawn and material probes were answered: by the thread's own
+  // table, by the shared one, or not at all and the entry was computed.
+  uint64_t probes[2] = {}, hits[2] = {}, sharedHits[2] = {};
+
+  for (size_t i = 0; i < Threads.size(); ++i)
+  {
+      probes[0] += Threads[i]->pawnsTable.probes;
+      hits[0] += Threads[i]->pawnsTable.hits;
+      sharedHits[0] += Threads[i]->pawnsTable.sharedHits;
+      probes[1] += Threads[i]->materialTable.probes;
+      hits[1] += Threads[i]->materialTable.hits;
+      sharedHits[1] += Threads[i]->materialTable.sharedHits;
+  }
+
+  for (int i = 0; i < 2; ++i)
+  {
+      double n = double(std::max(probes[i], uint64_t(1))) / 100;
+
+      cerr << (i == 0 ? "Pawn hash       : " : "Material hash   : ")
+           << std::fixed << std::setprecision(1)
+           << hits[i] / n << "% thread, " << sharedHits[i] / n << "% shared, "
+           << (probes[i] - hits[i] - sharedHits[i]) / n << "% miss" << endl;
+  }
 }
@@ -120,6 +120,9 @@ namespace {
 
 namespace Material {
 
+SharedTable Shared; // Shared by all the threads, off unless enabled by UCI
+
+
 /// Material::probe() takes a position object as input, looks up a MaterialEntry
 /// object, and returns a pointer to it. If the material configuration is not
 /// already present in the table, it is computed and stored there, so we don't
@@ -133,8 +136,20 @@ namespace Material {
   // If e->key matches the position's material hash key, it means that we
   // have analysed this material configuration before, and we can simply
   // return the information we found the last time instead of recomputing it.
+  ++entries.probes;
   if (e->key == key)
+  {
+      ++entries.hits;
+      return e;
+  }
+
+  // Maybe another thread has analysed it, then the shared table gives us a
+  // copy of its entry.
+  if (Shared.probe(key, e))
+  {
+      ++entries.sharedHits;
       return e;
+  }
 
   std::memset(e, 0, sizeof(Entry));
   e->key = key;
@@ -253,6 +268,7 @@ e->scalingFunction[BLACK] = NULL;
     pos.count<BISHOP>(BLACK)    , pos.count<ROOK>(BLACK), pos.count<QUEEN >(BLACK) } };
 
   e->value = (int16_t)((imbalance<WHITE>(pieceCount) - imbalance<BLACK>(pieceCount)) / 16);
+  Shared.store(key, e);
   return e;
 }
 
@@ -72,7 +72,14 @@ ScaleFactor (*scalingFunction[COLOR_NB])(const Position&);
   Phase gamePhase;
 };
 
-typedef HashTable<Entry, 8192> Table;
+// Entries of each thread's own table, alone or in front of the shared one
+const int TableSize = 8192;
+const int CacheSize = 512;
+
+typedef HashTable<Entry, TableSize> Table;
+typedef SharedHashTable<Entry> SharedTable;
+
+extern SharedTable Shared;
 
 //Entry* probe(const Position& pos, Table& entries, Endgames& endgames);
 Entry* probe(const Position& pos, Table& entries);
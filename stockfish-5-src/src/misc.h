@@ -20,6 +20,7 @@
 #ifndef MISC_H_INCLUDED
 #define MISC_H_INCLUDED
 
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -49,13 +50,106 @@ namespace Time {
 }
 
 
+/// HashTable is the per-thread pawn or material hash table. Size is the default
+/// number of entries, resize() can change it to any other power of two. When
+/// a SharedHashTable is in use, this table is only a small cache in front of
+/// it. The counters are updated by the probe functions and read by bench.
+
 template<class Entry, int Size>
 struct HashTable {
-  HashTable() : table(Size, Entry()) {}
-  Entry* operator[](Key k) { return &table[(uint32_t)k & (Size - 1)]; }
+  HashTable() : probes(0), hits(0), sharedHits(0), table(Size, Entry()), mask(Size - 1) {}
+  Entry* operator[](Key k) { return &table[(uint32_t)k & mask]; }
+
+  void resize(size_t size) {
+    if (size != table.size())
+    {
+        table.assign(size, Entry());
+        mask = size - 1;
+    }
+  }
+
+  uint64_t probes, hits, sharedHits;
 
 private:
   std::vector<Entry> table;
+  size_t mask;
+};
+
+
+/// SharedHashTable is a pawn or material hash table shared by all the threads,
+/// probed after a miss in the thread's own HashTable. It is lock-free: each slot
+/// holds a copy of an entry and a check word, which is the key XORed with all
+/// the words of the entry. A reader copies the slot and accepts it only if the
+/// words of its copy XOR back to the key it looks for, so a slot that another
+/// thread is rewriting at the same time is seen as a miss, never as a corrupted
+/// entry. The accepted copy goes into the reader's own table, which keeps the
+/// rule that a probed entry is owned by the thread. A table of size 0 is off.
+
+template<class Entry>
+struct SharedHashTable {
+  SharedHashTable() : mask(0) {}
+
+  void resize(size_t mbSize) {
+
+    size_t size = 0;
+
+    if (mbSize)
+        for (size = 1; 2 * size * sizeof(Slot) <= (mbSize << 20); size *= 2) {}
+
+    if (size != table.size())
+    {
+        table.assign(size, Slot());
+        mask = size - 1;
+    }
+  }
+
+  bool probe(Key k, Entry* e) const {
+
+    if (table.empty())
+        return false;
+
+    const volatile uint64_t* w = table[(uint32_t)k & mask].words;
+    uint64_t buf[Words], check = k;
+
+    for (int i = 0; i < Words; ++i)
+        check ^= (buf[i] = w[i]);
+
+    if (check != w[Words])
+        return false;
+
+    std::memcpy(e, buf, sizeof(Entry));
+    return true;
+  }
+
+  void store(Key k, const Entry* e) {
+
+    if (table.empty())
+        return;
+
+    volatile uint64_t* w = table[(uint32_t)k & mask].words;
+    uint64_t buf[Words] = {}, check = k;
+
+    std::memcpy(buf, e, sizeof(Entry));
+
+    for (int i = 0; i < Words; ++i)
+    {
+        w[i] = buf[i];
+        check ^= buf[i];
+    }
+
+    w[Words] = check;
+  }
+
+private:
+  static const int Words = (sizeof(Entry) + 7) / 8;
+
+  struct Slot {
+    Slot() { std::memset(words, 0, sizeof(words)); }
+    uint64_t words[Words + 1]; // Entry, then the check word
+  };
+
+  std::vector<Slot> table;
+  size_t mask;
 };
 
 
@@ -209,6 +209,9 @@ namespace {
 
 namespace Pawns {
 
+SharedTable Shared; // Shared by all the threads, off unless enabled by UCI
+
+
 /// init() initializes some tables by formula instead of hard-coding their values
 
 void init() {
@@ -227,18 +230,30 @@ void init() {
 
 /// probe() takes a position object as input, computes a Entry object, and returns
 /// a pointer to it. The result is also stored in a hash table, so we don't have
-/// to recompute everything when the same pawn structure occurs again.
+/// to recompute everything when the same pawn structure occurs again. After a
+/// miss in the thread's own table the shared one, if in use, is tried first.
 
 Entry* probe(const Position& pos, Table& entries) {
 
   Key key = pos.pawn_key();
   Entry* e = entries[key];
 
+  ++entries.probes;
   if (e->key == key)
+  {
+      ++entries.hits;
+      return e;
+  }
+
+  if (Shared.probe(key, e))
+  {
+      ++entries.sharedHits;
       return e;
+  }
 
   e->key = key;
   e->value = evaluate<WHITE>(pos, e) - evaluate<BLACK>(pos, e);
+  Shared.store(key, e);
   return e;
 }
 
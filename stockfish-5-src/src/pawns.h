@@ -74,7 +74,14 @@ struct Entry {
   int pawnsOnSquares[COLOR_NB][COLOR_NB]; // [color][light/dark squares]
 };
 
-typedef HashTable<Entry, 16384> Table;
+// Entries of each thread's own table, alone or in front of the shared one
+const int TableSize = 16384;
+const int CacheSize = 1024;
+
+typedef HashTable<Entry, TableSize> Table;
+typedef SharedHashTable<Entry> SharedTable;
+
+extern SharedTable Shared;
 
 void init();
 Entry* probe(const Position& pos, Table& entries);
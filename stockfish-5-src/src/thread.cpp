@@ -209,7 +209,8 @@ void ThreadPool::exit() {
 // UCI options and creates/destroys threads to match the requested number. Thread
 // objects are dynamically allocated to avoid creating all possible threads
 // in advance (which include pawns and material tables), even if only a few
-// are to be used.
+// are to be used. It also sets up the shared pawn and material tables: when
+// they are in use, each thread keeps only a small table in front of them.
 
 void ThreadPool::read_uci_options() {
 
@@ -230,6 +231,17 @@ void ThreadPool::read_uci_options() {
       delete_thread(back());
       pop_back();
   }
+
+  bool shared = Options["Shared Eval Hash"];
+
+  Pawns::Shared.resize(shared ? size_t(Options["Pawn Hash"]) : 0);
+  Material::Shared.resize(shared ? size_t(Options["Material Hash"]) : 0);
+
+  for (iterator it = begin(); it != end(); ++it)
+  {
+      (*it)->pawnsTable.resize(shared ? Pawns::CacheSize : Pawns::TableSize);
+      (*it)->materialTable.resize(shared ? Material::CacheSize : Material::TableSize);
+  }
 }
 
 
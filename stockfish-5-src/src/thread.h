@@ -109,6 +109,8 @@ struct ThreadBase {
 /// and especially split points. We also use per-thread pawn and material hash
 /// tables so that once we get a pointer to an entry its life time is unlimited
 /// and we don't have to care about someone changing the entry under our feet.
+/// With the shared tables enabled they are small and only cache copies of the
+/// shared entries.
 
 struct Thread : public ThreadBase {
 
@@ -73,6 +73,9 @@ void init(OptionsMap& o) {
   o["Threads"]                  << Option(1, 1, MAX_THREADS, on_threads);
   o["Hash"]                     << Option(32, 1, 16384, on_hash_size);
   o["Clear Hash"]               << Option(on_clear_hash);
+  o["Shared Eval Hash"]         << Option(false, on_threads);
+  o["Pawn Hash"]                << Option(16, 1, 1024, on_threads);
+  o["Material Hash"]            << Option(4, 1, 1024, on_threads);
   o["Ponder"]                   << Option(true);
   o["OwnBook"]                  << Option(false);
   o["MultiPV"]                  << Option(1, 1, 500);
@@ -32,11 +32,16 @@
     #define USING_INTRINSICS
 #endif
 
+#include <cstring>
 #include <iostream>
 
 #include "bitboard.h"
 #include "direction.h"
 
+#if !defined(_MSC_VER) && (defined(USE_POPCNT) || defined(USE_PEXT))
+#include <cpuid.h>
+#endif
+
 
 ////
 //// Constants and variables
@@ -264,12 +269,16 @@ Bitboard BishopPseudoAttacks[64];
 Bitboard RookPseudoAttacks[64];
 Bitboard QueenPseudoAttacks[64];
 
+bool UsePopCnt = false;
+bool UsePext = false;
+
 
 ////
 //// Local definitions
 ////
 
 namespace {
+  void init_cpu_features();
   void init_masks();
   void init_ray_bitboards();
   void init_attacks();
@@ -312,6 +321,7 @@ void print_bitboard(Bitboard b) {
 void init_bitboards() {
   int rookDeltas[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
   int bishopDeltas[4][2] = {{1,1},{-1,1},{1,-1},{-1,-1}};
+  init_cpu_features(); // Before the slider tables, their layout depends on it
   init_masks();
   init_ray_bitboards();
   init_attacks();
@@ -328,6 +338,18 @@ void init_bitboards() {
 }
 
 
+/// bitboard_backend() returns a short description of the bit counting and
+/// slider attack code selected by init_bitboards().
+
+const char *bitboard_backend() {
+  if (UsePopCnt && UsePext)
+      return "popcnt, pext";
+  if (UsePopCnt)
+      return "popcnt, magics";
+  return "software, magics";
+}
+
+
 #if defined(USE_FOLDED_BITSCAN)
 
 static const int BitTable[64] = {
@@ -432,6 +454,56 @@ namespace {
   // understand, but they all seem to work correctly, and it should never
   // be necessary to touch any of them.
 
+  // init_cpu_features() queries CPUID and selects the hardware backends.
+  // PEXT is microcoded and much slower than a magic multiply on AMD
+  // processors before family 19h (Zen 3), so it is not used there.
+
+  void init_cpu_features() {
+#if defined(USE_POPCNT) || defined(USE_PEXT)
+    unsigned a, b, c, d, family;
+    char vendor[13];
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    a = info[0], b = info[1], c = info[2], d = info[3];
+#else
+    __cpuid(0, a, b, c, d);
+#endif
+    unsigned maxLeaf = a;
+    memcpy(vendor, &b, 4);
+    memcpy(vendor + 4, &d, 4);
+    memcpy(vendor + 8, &c, 4);
+    vendor[12] = 0;
+
+#if defined(_MSC_VER)
+    __cpuid(info, 1);
+    a = info[0], c = info[2];
+#else
+    __cpuid(1, a, b, c, d);
+#endif
+    family = ((a >> 8) & 0xF) + ((a >> 20) & 0xFF);
+
+#if defined(USE_POPCNT)
+    UsePopCnt = (c >> 23) & 1;
+#endif
+
+#if defined(USE_PEXT)
+    if (maxLeaf >= 7)
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, 7, 0);
+        b = info[1];
+#else
+        __cpuid_count(7, 0, a, b, c, d);
+#endif
+        UsePext =   ((b >> 8) & 1)
+                 && (strcmp(vendor, "AuthenticAMD") != 0 || family >= 0x19);
+    }
+#endif
+#endif
+  }
+
+
   void init_masks() {
     for(Square s = SQ_A1; s <= SQ_H8; s++) {
       SetMaskBB[s] = (1ULL << s);
@@ -545,6 +617,12 @@ namespace {
           sliding_attacks(i, b, 4, deltas);
 #else
         b = index_to_bitboard(k, mask[i]);
+#if defined(USE_PEXT)
+        if(UsePext)
+          attacks[index + pext_hw(b, mask[i])] =
+            sliding_attacks(i, b, 4, deltas);
+        else
+#endif
         attacks[index + ((b * mult[i]) >> shift[i])] =
           sliding_attacks(i, b, 4, deltas);
 #endif
@@ -59,10 +59,31 @@
 
 #endif
 
+// On x86-64 the POPCNT bit count and the BMI2 PEXT indexed slider attacks
+// are always compiled in.  init_bitboards() switches them on at startup if
+// CPUID reports them, so the same binary still runs on older processors.
+
+#if defined(IS_64BIT) && (defined(__x86_64) || defined(_WIN64))
+
+#if defined(BITCOUNT_SWAR_64)
+#define USE_POPCNT
+#endif
+
+#if !defined(USE_32BIT_ATTACKS) && !defined(USE_COMPACT_ROOK_ATTACKS)
+#define USE_PEXT
+#endif
+
+#endif
+
 ////
 //// Includes
 ////
 
+#if defined(_MSC_VER) && (defined(USE_POPCNT) || defined(USE_PEXT))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 #include "direction.h"
 #include "piece.h"
 #include "square.h"
@@ -143,11 +164,47 @@ extern Bitboard BishopPseudoAttacks[64];
 extern Bitboard RookPseudoAttacks[64];
 extern Bitboard QueenPseudoAttacks[64];
 
+extern bool UsePopCnt;
+extern bool UsePext;
+
 
 ////
 //// Inline functions
 ////
 
+/// Hardware instructions behind the optional backends.  They are written as
+/// inline assembly with gcc and icc so that no -mpopcnt or -mbmi2 switch is
+/// needed, and callers must check UsePopCnt or UsePext first.
+
+#if defined(USE_POPCNT)
+
+inline int popcnt_hw(Bitboard b) {
+#if defined(_MSC_VER)
+  return int(__popcnt64(b));
+#else
+  Bitboard r;
+  __asm__("popcntq %1, %0" : "=r" (r) : "r" (b));
+  return int(r);
+#endif
+}
+
+#endif // defined(USE_POPCNT)
+
+#if defined(USE_PEXT)
+
+inline Bitboard pext_hw(Bitboard b, Bitboard mask) {
+#if defined(_MSC_VER)
+  return _pext_u64(b, mask);
+#else
+  Bitboard r;
+  __asm__("pextq %2, %1, %0" : "=r" (r) : "r" (b), "r" (mask));
+  return r;
+#endif
+}
+
+#endif // defined(USE_PEXT)
+
+
 /// Functions for testing whether a given bit is set in a bitboard, and for
 /// setting and clearing bits.
 
@@ -279,6 +336,10 @@ inline Bitboard rook_attacks_bb(Square s, Bitboard blockers) {
 #else
 
 inline Bitboard rook_attacks_bb(Square s, Bitboard blockers) {
+#if defined(USE_PEXT)
+  if (UsePext)
+      return RAttacks[RAttackIndex[s] + pext_hw(blockers, RMask[s])];
+#endif
   Bitboard b = blockers & RMask[s];
   return RAttacks[RAttackIndex[s] + ((b * RMult[s]) >> RShift[s])];
 }
@@ -298,6 +359,10 @@ inline Bitboard bishop_attacks_bb(Square s, Bitboard blockers) {
 #else // defined(USE_32BIT_ATTACKS)
 
 inline Bitboard bishop_attacks_bb(Square s, Bitboard blockers) {
+#if defined(USE_PEXT)
+  if (UsePext)
+      return BAttacks[BAttackIndex[s] + pext_hw(blockers, BMask[s])];
+#endif
   Bitboard b = blockers & BMask[s];
   return BAttacks[BAttackIndex[s] + ((b * BMult[s]) >> BShift[s])];
 }
@@ -405,6 +470,10 @@ inline int count_1s_max_15(Bitboard b) {
 #elif defined(BITCOUNT_SWAR_64)
 
 inline int count_1s(Bitboard b) {
+#if defined(USE_POPCNT)
+  if (UsePopCnt)
+      return popcnt_hw(b);
+#endif
   b -= ((b>>1) & 0x5555555555555555ULL);
   b = ((b>>2) & 0x3333333333333333ULL) + (b & 0x3333333333333333ULL);
   b = ((b>>4) + b) & 0x0F0F0F0F0F0F0F0FULL;
@@ -413,6 +482,17 @@ inline int count_1s(Bitboard b) {
 }
 
 inline int count_1s_max_15(Bitboard b) {
+#if defined(USE_POPCNT)
+  // The software version below is exact only up to 15 bits and returns a
+  // different value for wider sets (queen mobility can reach 27). Fall back
+  // to it in that case so evaluation is identical on every backend.
+  if (UsePopCnt)
+  {
+      int n = popcnt_hw(b);
+      if (n < 16)
+          return n;
+  }
+#endif
   b -= (b>>1) & 0x5555555555555555ULL;
   b = ((b>>2) & 0x3333333333333333ULL) + (b & 0x3333333333333333ULL);
   b *= 0x1111111111111111ULL;
@@ -428,6 +508,7 @@ inline int count_1s_max_15(Bitboard b) {
 
 extern void print_bitboard(Bitboard b);
 extern void init_bitboards();
+extern const char *bitboard_backend();
 extern Square first_1(Bitboard b);
 extern Square pop_1st_bit(Bitboard *b);
 
@@ -88,6 +88,7 @@ int main(int argc, char *argv[]) {
   std::cout << engine_name() << ".  Copyright (C) "
             << "2004-2008 Tord Romstad, Marco Costalba. "
             << std::endl;
+  std::cout << "Bitboards: " << bitboard_backend() << std::endl;
 
   // Enter UCI mode
   uci_main_loop();
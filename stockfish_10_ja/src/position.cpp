@@ -31,6 +31,7 @@
 #include "movepick.h"
 #include "position.h"
 #include "psqtab.h"
+#include "tt.h"
 #include "ucioption.h"
 
 
@@ -739,11 +740,20 @@ void Position::do_move(Move m, UndoInfo& u, Bitboard dcCandidates) {
   rule50++;
 
   if (move_is_castle(m))
+  {
       do_castle_move(m);
+      TT.prefetch(key ^ zobSideToMove);
+  }
   else if (move_promotion(m))
+  {
       do_promotion_move(m, u);
+      TT.prefetch(key ^ zobSideToMove);
+  }
   else if (move_is_ep(m))
+  {
       do_ep_move(m);
+      TT.prefetch(key ^ zobSideToMove);
+  }
   else
   {
     Color us = side_to_move();
@@ -823,6 +833,10 @@ void Position::do_move(Move m, UndoInfo& u, Bitboard dcCandidates) {
     castleRights &= castleRightsMask[to];
     key ^= zobCastle[castleRights];
 
+    // The key is complete except for the side to move, start loading the
+    // TT cluster of the new position while the checkers are computed.
+    TT.prefetch(key ^ zobSideToMove);
+
     // Update checkers bitboard
     checkersBB = EmptyBoardBB;
     Square ksq = king_square(them);
@@ -1526,6 +1540,8 @@ void Position::do_null_move(UndoInfo &u) {
   gamePly++;
   key ^= zobSideToMove;
 
+  TT.prefetch(key);
+
   mgValue += (sideToMove == WHITE)? TempoValueMidgame : -TempoValueMidgame;
   egValue += (sideToMove == WHITE)? TempoValueEndgame : -TempoValueEndgame;
 
@@ -215,10 +215,12 @@ namespace {
   bool AllThreadsShouldExit = false;
   const int MaxActiveSplitPoints = 8;
   SplitPoint SplitPointStack[THREAD_MAX][MaxActiveSplitPoints];
+  Position RootPosition;
   bool Idle = true;
 
 #if !defined(_MSC_VER)
   pthread_cond_t WaitCond;
+  pthread_cond_t SleepCond[THREAD_MAX];
   pthread_mutex_t WaitLock;
 #else
   HANDLE SitIdleEvent[THREAD_MAX];
@@ -237,6 +239,7 @@ namespace {
                 Depth depth, int ply, int threadID);
   void sp_search(SplitPoint *sp, int threadID);
   void sp_search_pv(SplitPoint *sp, int threadID);
+  void sp_init(const SplitPoint *sp, Position &pos, SearchStack ss[]);
   void init_search_stack(SearchStack ss[]);
   void init_node(const Position &pos, SearchStack ss[], int ply, int threadID);
   void update_pv(SearchStack ss[], int ply);
@@ -246,7 +249,10 @@ namespace {
                   bool singleReply, bool mateThreat);
   bool ok_to_do_nullmove(const Position &pos);
   bool ok_to_prune(const Position &pos, Move m, Move threat, Depth d);
+  const TTEntry* retrieve_tt(const Position &pos, int threadID);
   bool ok_to_use_TT(const TTEntry* tte, Depth depth, Value beta, int ply);
+  Value static_value(const Position &pos, Value &staticValue, EvalInfo &ei,
+                     int threadID);
   bool ok_to_history(const Position &pos, Move m);
   void update_history(const Position& pos, Move m, Depth depth,
                       Move movesSearched[], int moveCount);
@@ -254,6 +260,7 @@ namespace {
   bool fail_high_ply_1();
   int current_search_time();
   int nps();
+  int tt_hit_rate();
   void poll();
   void ponderhit();
   void print_current_line(SearchStack ss[], int ply, int threadID);
@@ -270,6 +277,8 @@ namespace {
              int *moves, MovePicker *mp, Bitboard dcCandidates, int master,
              bool pvNode);
   void wake_sleeping_threads();
+  void sleep_until_work(int threadID, SplitPoint *waitSp);
+  void wake_thread(int threadID);
 
 #if !defined(_MSC_VER)
   void *init_thread(void *threadID);
@@ -336,6 +345,9 @@ void think(const Position &pos, bool infinite, bool ponder, int side_to_move,
   for (int i = 0; i < THREAD_MAX; i++)
   {
       Threads[i].nodes = 0ULL;
+      Threads[i].splits = 0ULL;
+      Threads[i].ttProbes = 0ULL;
+      Threads[i].ttHits = 0ULL;
       Threads[i].failHighPly1 = false;
   }
   NodesSincePoll = 0;
@@ -534,6 +546,8 @@ void init_threads() {
 #if !defined(_MSC_VER)
   pthread_mutex_init(&WaitLock, NULL);
   pthread_cond_init(&WaitCond, NULL);
+  for (i = 0; i < THREAD_MAX; i++)
+      pthread_cond_init(&SleepCond[i], NULL);
 #else
   for (i = 0; i < THREAD_MAX; i++)
       SitIdleEvent[i] = CreateEvent(0, FALSE, FALSE, 0);
@@ -576,6 +590,7 @@ void stop_threads() {
   for (int i = 1; i < THREAD_MAX; i++)
   {
       Threads[i].stop = true;
+      wake_thread(i);
       while(Threads[i].running);
   }
   destroy_split_point_stack();
@@ -606,6 +621,9 @@ namespace {
     Position p(pos);
     SearchStack ss[PLY_MAX_PLUS_2];
 
+    // Threads joining a split point replay their move path from here
+    RootPosition.copy(p);
+
     // searchMoves are verified, copied, scored and sorted
     RootMoveList rml(p, searchMoves);
 
@@ -704,11 +722,15 @@ namespace {
     if (PonderSearch)
         wait_for_stop_or_ponderhit();
     else
+    {
         // Print final search statistics
         std::cout << "info nodes " << nodes_searched()
                   << " nps " << nps()
                   << " time " << current_search_time()
-                  << " hashfull " << TT.full() << std::endl;
+                  << " hashfull " << TT.full() << std::endl
+                  << "info string hash hit rate " << tt_hit_rate()
+                  << " permill" << std::endl;
+    }
 
     // Print the best move and the ponder move to the standard output
     std::cout << "bestmove " << ss[0].pv[0];
@@ -720,8 +742,15 @@ namespace {
     if (UseLogFile)
     {
         UndoInfo u;
+        uint64_t splits = 0ULL;
+        for (int i = 0; i < ActiveThreads; i++)
+            splits += Threads[i].splits;
+
         LogFile << "Nodes: " << nodes_searched() << std::endl
                 << "Nodes/second: " << nps() << std::endl
+                << "Split points: " << splits << std::endl
+                << "Hash hit rate: " << tt_hit_rate() << " permill" << std::endl
+                << "Hash full: " << TT.full() << " permill" << std::endl
                 << "Best move: " << move_to_san(p, ss[0].pv[0]) << std::endl;
 
         p.do_move(ss[0].pv[0], u);
@@ -921,7 +950,7 @@ namespace {
 
     // Transposition table lookup. At PV nodes, we don't use the TT for
     // pruning, but only for move ordering.
-    const TTEntry* tte = TT.retrieve(pos);
+    const TTEntry* tte = retrieve_tt(pos, threadID);
     Move ttMove = (tte ? tte->move() : MOVE_NONE);
 
     // Go with internal iterative deepening if we don't have a TT move
@@ -1120,7 +1149,7 @@ namespace {
         return beta - 1;
 
     // Transposition table lookup
-    const TTEntry* tte = TT.retrieve(pos);
+    const TTEntry* tte = retrieve_tt(pos, threadID);
     Move ttMove = (tte ? tte->move() : MOVE_NONE);
 
     if (tte && ok_to_use_TT(tte, depth, beta, ply))
@@ -1129,6 +1158,12 @@ namespace {
         return value_from_tt(tte->value(), ply);
     }
 
+    // The static evaluation is computed only when needed, and not at all if
+    // the TT entry already has it. Read it now, the entry can be replaced
+    // during the null move and IID searches.
+    Value staticValue = (tte ? tte->static_value() : VALUE_NONE);
+    ei.futilityMargin = (tte ? tte->static_value_margin() : Value(0));
+
     Value approximateEval = quick_evaluate(pos);
     bool mateThreat = false;
     bool isCheck = pos.is_check();
@@ -1183,7 +1218,7 @@ namespace {
 
     // Go with internal iterative deepening if we don't have a TT move
     if (UseIIDAtNonPVNodes && ttMove == MOVE_NONE && depth >= 8*OnePly &&
-        evaluate(pos, ei, threadID) >= beta - IIDMargin)
+        static_value(pos, staticValue, ei, threadID) >= beta - IIDMargin)
     {
         search(pos, ss, beta, Min(depth/2, depth-2*OnePly), ply, false, threadID);
         ttMove = ss[ply].pv[ply];
@@ -1236,7 +1271,7 @@ namespace {
           if (depth < 3 * OnePly && approximateEval < beta)
           {
               if (futilityValue == VALUE_NONE)
-                  futilityValue =  evaluate(pos, ei, threadID)
+                  futilityValue =  static_value(pos, staticValue, ei, threadID)
                                 + (depth < 2 * OnePly ? FutilityMargin1 : FutilityMargin2);
 
               if (futilityValue < beta)
@@ -1314,7 +1349,8 @@ namespace {
         return bestValue;
 
     if (bestValue < beta)
-        TT.store(pos, value_to_tt(bestValue, ply), depth, MOVE_NONE, VALUE_TYPE_UPPER);
+        TT.store(pos, value_to_tt(bestValue, ply), depth, MOVE_NONE, VALUE_TYPE_UPPER,
+                 staticValue, ei.futilityMargin);
     else
     {
         Move m = ss[ply].pv[ply];
@@ -1327,7 +1363,8 @@ namespace {
                 ss[ply].killer1 = m;
             }
         }
-        TT.store(pos, value_to_tt(bestValue, ply), depth, m, VALUE_TYPE_LOWER);
+        TT.store(pos, value_to_tt(bestValue, ply), depth, m, VALUE_TYPE_LOWER,
+                 staticValue, ei.futilityMargin);
     }
     return bestValue;
   }
@@ -1359,22 +1396,30 @@ namespace {
         return VALUE_DRAW;
 
     // Transposition table lookup
-    const TTEntry* tte = TT.retrieve(pos);
+    const TTEntry* tte = retrieve_tt(pos, threadID);
     if (tte && ok_to_use_TT(tte, depth, beta, ply))
         return value_from_tt(tte->value(), ply);
 
-    // Evaluate the position statically
-    Value staticValue = evaluate(pos, ei, threadID);
+    // Evaluate the position statically, unless the TT entry has it already
+    Value staticValue = (tte ? tte->static_value() : VALUE_NONE);
+    ei.futilityMargin = (tte ? tte->static_value_margin() : Value(0));
+    static_value(pos, staticValue, ei, threadID);
 
     if (ply == PLY_MAX - 1)
         return staticValue;
 
     // Initialize "stand pat score", and return it immediately if it is
-    // at least beta.
+    // at least beta. The bound is stored so that the evaluation is kept
+    // for the next visit.
     Value bestValue = (pos.is_check() ? -VALUE_INFINITE : staticValue);
 
     if (bestValue >= beta)
+    {
+        if (!tte)
+            TT.store(pos, value_to_tt(bestValue, ply), depth, MOVE_NONE, VALUE_TYPE_LOWER,
+                     staticValue, ei.futilityMargin);
         return bestValue;
+    }
 
     if (bestValue > alpha)
         alpha = bestValue;
@@ -1461,7 +1506,8 @@ namespace {
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
 
     // Update transposition table
-    TT.store(pos, value_to_tt(bestValue, ply), depth, MOVE_NONE, VALUE_TYPE_EXACT);
+    TT.store(pos, value_to_tt(bestValue, ply), depth, MOVE_NONE, VALUE_TYPE_EXACT,
+             staticValue, ei.futilityMargin);
 
     return bestValue;
   }
@@ -1480,8 +1526,9 @@ namespace {
     assert(threadID >= 0 && threadID < ActiveThreads);
     assert(ActiveThreads > 1);
 
-    Position pos = Position(sp->pos);
-    SearchStack *ss = sp->sstack[threadID];
+    Position pos;
+    SearchStack ss[PLY_MAX_PLUS_2];
+    sp_init(sp, pos, ss);
     Value value;
     Move move;
     bool isCheck = pos.is_check();
@@ -1579,10 +1626,15 @@ namespace {
             if (sp->slaves[i])
                 Threads[i].stop = true;
 
-    sp->cpus--;
+    int master = sp->master;
+    bool last = (--sp->cpus == 0);
     sp->slaves[threadID] = 0;
 
     lock_release(&(sp->lock));
+
+    // The master may be asleep waiting for its slaves:
+    if (last && master != threadID)
+        wake_thread(master);
   }
 
 
@@ -1599,8 +1651,9 @@ namespace {
     assert(threadID >= 0 && threadID < ActiveThreads);
     assert(ActiveThreads > 1);
 
-    Position pos = Position(sp->pos);
-    SearchStack *ss = sp->sstack[threadID];
+    Position pos;
+    SearchStack ss[PLY_MAX_PLUS_2];
+    sp_init(sp, pos, ss);
     Value value;
     Move move;
 
@@ -1713,10 +1766,48 @@ namespace {
             if (sp->slaves[i])
                 Threads[i].stop = true;
 
-    sp->cpus--;
+    int master = sp->master;
+    bool last = (--sp->cpus == 0);
     sp->slaves[threadID] = 0;
 
     lock_release(&(sp->lock));
+
+    // The master may be asleep waiting for its slaves:
+    if (last && master != threadID)
+        wake_thread(master);
+  }
+
+
+  // sp_init() prepares the position and the search stack of a thread which
+  // is about to search at the split point sp.  Instead of copying a Position
+  // and a search stack for every thread when splitting, each thread replays
+  // the moves leading from the root to the split point on its own copy of
+  // the root position.  Below the split point, only the killers and the
+  // threat move are read from the master's stack, so only those are copied.
+
+  void sp_init(const SplitPoint *sp, Position &pos, SearchStack ss[]) {
+
+    SearchStack *pss = sp->parentSstack;
+    UndoInfo u;
+
+    pos.copy(RootPosition);
+    for (int i = 0; i < sp->ply; i++)
+    {
+        ss[i].currentMove = pss[i].currentMove;
+        if (ss[i].currentMove == MOVE_NULL)
+            pos.do_null_move(u);
+        else
+            pos.do_move(ss[i].currentMove, u);
+    }
+    assert(pos.get_key() == sp->key);
+
+    for (int i = sp->ply; i <= sp->ply + 2; i++)
+    {
+        ss[i].mateKiller = pss[i].mateKiller;
+        ss[i].killer1 = pss[i].killer1;
+        ss[i].killer2 = pss[i].killer2;
+        ss[i].threatMove = pss[i].threatMove;
+    }
   }
 
 
@@ -2120,6 +2211,21 @@ namespace {
   }
 
 
+  // retrieve_tt() looks up the position in the transposition table, and
+  // counts the probe and the hit for the hit rate statistics.
+
+  const TTEntry* retrieve_tt(const Position &pos, int threadID) {
+
+    const TTEntry* tte = TT.retrieve(pos);
+
+    Threads[threadID].ttProbes++;
+    if (tte)
+        Threads[threadID].ttHits++;
+
+    return tte;
+  }
+
+
   // ok_to_use_TT() returns true if a transposition table score
   // can be used at a given point in search.
 
@@ -2136,6 +2242,20 @@ namespace {
   }
 
 
+  // static_value() returns the static evaluation of the position, calling
+  // evaluate() only if staticValue does not already hold it (because it was
+  // found in the transposition table or computed earlier at the same node).
+
+  Value static_value(const Position &pos, Value &staticValue, EvalInfo &ei,
+                     int threadID) {
+
+    if (staticValue == VALUE_NONE)
+        staticValue = evaluate(pos, ei, threadID);
+
+    return staticValue;
+  }
+
+
   // ok_to_history() returns true if a move m can be stored
   // in history. Should be a non capturing move.
 
@@ -2188,6 +2308,21 @@ namespace {
   }
 
 
+  // tt_hit_rate() returns the permill of transposition table probes which
+  // found the position, over all threads, for the current search.
+
+  int tt_hit_rate() {
+
+    uint64_t probes = 0ULL, hits = 0ULL;
+    for (int i = 0; i < ActiveThreads; i++)
+    {
+        probes += Threads[i].ttProbes;
+        hits += Threads[i].ttHits;
+    }
+    return (probes > 0)? int((hits * 1000) / probes) : 0;
+  }
+
+
   // poll() performs two different functions:  It polls for user input, and it
   // looks at the time consumed so far and decides if it's time to abort the
   // search.
@@ -2365,6 +2500,10 @@ namespace {
       // finished their work at this split point, return from the idle loop:
       if(waitSp != NULL && waitSp->cpus == 0)
         return;
+
+      // Nothing to do.  Sleep until split() assigns us work, or until the
+      // last thread at our own split point leaves it:
+      sleep_until_work(threadID, waitSp);
     }
 
     Threads[threadID].running = false;
@@ -2467,8 +2606,8 @@ namespace {
   // node (because no idle threads are available, or because we have no unused
   // split point objects), the function immediately returns false.  If
   // splitting is possible, a SplitPoint object is initialized with all the
-  // data that must be copied to the helper threads (the current position and
-  // search stack, alpha, beta, the search depth, etc.), and we tell our
+  // data that must be copied to the helper threads (alpha, beta, the search
+  // depth, etc., not the position and search stack), and we tell our
   // helper threads that they have been assigned work.  This will cause them
   // to instantly leave their idle loops and call sp_search_pv().  When all
   // threads have returned from sp_search_pv (or, equivalently, when
@@ -2479,6 +2618,7 @@ namespace {
              Depth depth, int *moves,
              MovePicker *mp, Bitboard dcCandidates, int master, bool pvNode) {
     assert(p.is_ok());
+    (void)p; // only checked in debug builds, helpers rebuild it in sp_init()
     assert(sstck != NULL);
     assert(ply >= 0 && ply < PLY_MAX);
     assert(*bestValue >= -VALUE_INFINITE && *bestValue <= *alpha);
@@ -2519,20 +2659,21 @@ namespace {
     splitPoint->mp = mp;
     splitPoint->moves = *moves;
     splitPoint->cpus = 1;
-    splitPoint->pos.copy(p);
     splitPoint->parentSstack = sstck;
+#if !defined(NDEBUG)
+    splitPoint->key = p.get_key();
+#endif
     for(i = 0; i < ActiveThreads; i++)
       splitPoint->slaves[i] = 0;
 
-    // Copy the current position and the search stack to the master thread:
-    memcpy(splitPoint->sstack[master], sstck, (ply+1)*sizeof(SearchStack));
     Threads[master].splitPoint = splitPoint;
+    Threads[master].splits++;
 
-    // Make copies of the current position and search stack for each thread:
+    // Pick the helper threads.  Nothing is copied here, each thread sets up
+    // its own position and search stack in sp_init():
     for(i = 0; i < ActiveThreads && splitPoint->cpus < MaxThreadsPerSplitPoint;
         i++)
       if(thread_is_available(i, master)) {
-        memcpy(splitPoint->sstack[i], sstck, (ply+1)*sizeof(SearchStack));
         Threads[i].splitPoint = splitPoint;
         splitPoint->slaves[i] = 1;
         splitPoint->cpus++;
@@ -2545,6 +2686,8 @@ namespace {
         Threads[i].workIsWaiting = true;
         Threads[i].idle = false;
         Threads[i].stop = false;
+        if(i != master)
+          wake_thread(i);
       }
 
     lock_release(&MPLock);
@@ -2594,6 +2737,44 @@ namespace {
   }
 
 
+  // sleep_until_work() blocks the thread with the given threadID until it
+  // has work waiting, until the split point "waitSp" (if non-NULL) has no
+  // threads left, or until the program exits.  The wakeup is sent by
+  // wake_thread(), so a waiting thread, including a master waiting for its
+  // slaves, uses no CPU time.
+
+  void sleep_until_work(int threadID, SplitPoint *waitSp) {
+#if !defined(_MSC_VER)
+    pthread_mutex_lock(&WaitLock);
+    while(   !Threads[threadID].workIsWaiting
+          && !(waitSp != NULL && waitSp->cpus == 0)
+          && !AllThreadsShouldExit)
+      pthread_cond_wait(&SleepCond[threadID], &WaitLock);
+    pthread_mutex_unlock(&WaitLock);
+#else
+    while(   !Threads[threadID].workIsWaiting
+          && !(waitSp != NULL && waitSp->cpus == 0)
+          && !AllThreadsShouldExit)
+      WaitForSingleObject(SitIdleEvent[threadID], INFINITE);
+#endif
+  }
+
+
+  // wake_thread() wakes up the thread with the given threadID if it sleeps
+  // in sleep_until_work().  The caller must have made the condition the
+  // thread waits for true before calling it.
+
+  void wake_thread(int threadID) {
+#if !defined(_MSC_VER)
+    pthread_mutex_lock(&WaitLock);
+    pthread_cond_signal(&SleepCond[threadID]);
+    pthread_mutex_unlock(&WaitLock);
+#else
+    SetEvent(SitIdleEvent[threadID]);
+#endif
+  }
+
+
   // init_thread() is the function which is called when a new thread is
   // launched.  It simply calls the idle_loop() function with the supplied
   // threadID.  There are two versions of this function; one for POSIX threads
@@ -43,10 +43,12 @@ const int THREAD_MAX = 8;
 //// Types
 ////
 
+// A split point holds only the state of the node being split.  Each thread
+// working at it rebuilds the position by replaying the moves in
+// parentSstack[0..ply-1] from the root, and searches on a stack of its own.
+
 struct SplitPoint {
   SplitPoint *parent;
-  Position pos;
-  SearchStack sstack[THREAD_MAX][PLY_MAX];
   SearchStack *parentSstack;
   int ply;
   Depth depth;
@@ -59,6 +61,9 @@ struct SplitPoint {
   volatile int moves;
   volatile int cpus;
   bool finished;
+#if !defined(NDEBUG)
+  Key key; // checked by the threads replaying the move path
+#endif
 };
 
 
@@ -66,6 +71,9 @@ struct Thread {
   SplitPoint *splitPoint;
   int activeSplitPoints;
   uint64_t nodes;
+  uint64_t splits;
+  uint64_t ttProbes;
+  uint64_t ttHits;
   bool failHighPly1;
   volatile bool stop;
   volatile bool running;
@@ -23,7 +23,9 @@
 ////
 
 #include <cassert>
-#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 #include "tt.h"
 
@@ -38,7 +40,7 @@ TranspositionTable::TranspositionTable(unsigned mbSize) {
 
   size = 0;
   generation = 0;
-  writes = 0;
+  mem = 0;
   entries = 0;
   set_size(mbSize);
 }
@@ -48,7 +50,7 @@ TranspositionTable::TranspositionTable(unsigned mbSize) {
 
 TranspositionTable::~TranspositionTable() {
 
-  delete [] entries;
+  delete [] mem;
 }
 
 
@@ -61,22 +63,24 @@ void TranspositionTable::set_size(unsigned mbSize) {
 
   unsigned newSize = 1024;
 
-  // We store a cluster of 4 TTEntry for each position and newSize is
-  // the maximum number of storable positions
-  for ( ; newSize * 4 * (sizeof(TTEntry)) <= (mbSize << 20); newSize *= 2);
+  // We store a cluster of ClusterSize TTEntry for each position and newSize
+  // is the maximum number of storable positions
+  for ( ; newSize * sizeof(TTCluster) <= (mbSize << 20); newSize *= 2);
   newSize /= 2;
   if (newSize != size)
   {
     size = newSize;
-    delete [] entries;
-    entries = new TTEntry[size * 4];
-    if (!entries)
+    delete [] mem;
+    mem = new char[size * sizeof(TTCluster) + CacheLineSize - 1];
+    if (!mem)
     {
       std::cerr << "Failed to allocate " << mbSize
                 << " MB for transposition table."
                 << std::endl;
       exit(EXIT_FAILURE);
     }
+    // Align the clusters to cache lines
+    entries = (TTCluster*)((size_t(mem) + CacheLineSize - 1) & ~size_t(CacheLineSize - 1));
     clear();
   }
 }
@@ -89,38 +93,44 @@ void TranspositionTable::set_size(unsigned mbSize) {
 
 void TranspositionTable::clear() {
 
-  memset(entries, 0, size * 4 * sizeof(TTEntry));
+  memset(entries, 0, size * sizeof(TTCluster));
 }
 
 
 /// TranspositionTable::store writes a new entry containing a position,
 /// a value, a value type, a search depth, and a best move to the
-/// transposition table.  The transposition table is organized in clusters
-/// of four TTEntry objects, and when a new entry is written, it replaces
-/// the least valuable of the four entries in a cluster.  A TTEntry t1 is
-/// considered to be more valuable than a TTEntry t2 if t1 is from the
+/// transposition table, optionally with the static evaluation of the
+/// position and its futility margin.  The transposition table is organized
+/// in clusters of four TTEntry objects, and when a new entry is written, it
+/// replaces the least valuable of the four entries in a cluster.  A TTEntry
+/// t1 is considered to be more valuable than a TTEntry t2 if t1 is from the
 /// current search and t2 is from a previous search, or if the depth of t1
 /// is bigger than the depth of t2.
 
 void TranspositionTable::store(const Position &pos, Value v, Depth d,
-                               Move m, ValueType type) {
+                               Move m, ValueType type, Value statV, Value statM) {
   TTEntry *tte, *replace;
+  uint32_t posKey32 = uint32_t(pos.get_key() >> 32);
 
-  tte = replace = first_entry(pos);
-  for (int i = 0; i < 4; i++)
+  tte = replace = first_entry(pos.get_key());
+  for (int i = 0; i < ClusterSize; i++)
   {
     if (!(tte+i)->key()) // still empty
     {
-        *(tte+i) = TTEntry(pos.get_key(), v, type, d, m, generation);
-        writes++;
+        *(tte+i) = TTEntry(posKey32, v, type, d, m, generation, statV, statM);
         return;
     }
-    if ((tte+i)->key() == pos.get_key()) // overwrite old
+    if ((tte+i)->key() == posKey32) // overwrite old
     {
         if (m == MOVE_NONE)
             m = (tte+i)->move();
 
-        *(tte+i) = TTEntry(pos.get_key(), v, type, d, m, generation);
+        if (statV == VALUE_NONE)
+        {
+            statV = (tte+i)->static_value();
+            statM = (tte+i)->static_value_margin();
+        }
+        *(tte+i) = TTEntry(posKey32, v, type, d, m, generation, statV, statM);
         return;
     }
     if (   i == 0  // already is (replace == tte+i), common case
@@ -131,8 +141,7 @@ void TranspositionTable::store(const Position &pos, Value v, Depth d,
         || (tte+i)->depth() < replace->depth())
         replace = tte+i;
   }
-  *replace = TTEntry(pos.get_key(), v, type, d, m, generation);
-  writes++;
+  *replace = TTEntry(posKey32, v, type, d, m, generation, statV, statM);
 }
 
 
@@ -142,26 +151,17 @@ void TranspositionTable::store(const Position &pos, Value v, Depth d,
 
 const TTEntry* TranspositionTable::retrieve(const Position &pos) const {
 
-  TTEntry *tte = first_entry(pos);
+  TTEntry *tte = first_entry(pos.get_key());
+  uint32_t posKey32 = uint32_t(pos.get_key() >> 32);
+
+  for (int i = 0; i < ClusterSize; i++)
+      if ((tte+i)->key() == posKey32)
+          return tte+i;
 
-  for (int i = 0; i < 4; i++)
-  {
-      tte += i;
-      if (tte->key() == pos.get_key())
-          return tte;
-  }
   return NULL;
 }
 
 
-/// TranspositionTable::first_entry returns a pointer to the first
-/// entry of a cluster given a position.
-
-inline TTEntry* TranspositionTable::first_entry(const Position &pos) const {
-
-  return entries + (int(pos.get_key() & (size - 1)) << 2);
-}
-
 /// TranspositionTable::new_search() is called at the beginning of every new
 /// search.  It increments the "generation" variable, which is used to
 /// distinguish transposition table entries from previous searches from
@@ -170,7 +170,6 @@ inline TTEntry* TranspositionTable::first_entry(const Position &pos) const {
 void TranspositionTable::new_search() {
 
   generation++;
-  writes = 0;
 }
 
 
@@ -192,14 +191,22 @@ void TranspositionTable::insert_pv(const Position &pos, Move pv[]) {
 }
 
 
-/// TranspositionTable::full() returns the permill of all transposition table
-/// entries which have received at least one write during the current search.
-/// It is used to display the "info hashfull ..." information in UCI.
+/// TranspositionTable::full() returns the permill of transposition table
+/// entries which have been written during the current search.  It is used
+/// to display the "info hashfull ..." information in UCI.  Rather than
+/// estimating it from a write counter, it samples the first thousand entries
+/// and counts those of the current generation.
+
+int TranspositionTable::full() const {
 
-int TranspositionTable::full() {
+  int cnt = 0;
+  for (int i = 0; i < 1000 / ClusterSize; i++)
+      for (int j = 0; j < ClusterSize; j++)
+          if (   entries[i].data[j].key()
+              && entries[i].data[j].generation() == generation)
+              cnt++;
 
-  double N = double(size) * 4.0;
-  return int(1000 * (1 - exp(writes * log(1.0 - 1.0/N))));
+  return cnt * 1000 / (1000 / ClusterSize * ClusterSize);
 }
 
 
@@ -208,10 +215,8 @@ int TranspositionTable::full() {
 TTEntry::TTEntry() {
 }
 
-TTEntry::TTEntry(Key k, Value v, ValueType t, Depth d, Move m,
-                 int generation) :
-  key_ (k), data((m & 0x7FFFF) | (t << 20) | (generation << 23)),
-  value_(v), depth_(int16_t(d)) {}
-
-
-
+TTEntry::TTEntry(uint32_t k, Value v, ValueType t, Depth d, Move m,
+                 int generation, Value statV, Value statM) :
+  key32(k), data((m & 0x7FFFF) | (t << 20) | (generation << 23)),
+  value_(int16_t(v)), depth_(int16_t(d)),
+  staticValue(int16_t(statV)), staticValueMargin(int16_t(statM)) {}
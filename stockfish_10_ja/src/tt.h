@@ -25,6 +25,10 @@
 //// Includes
 ////
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
 #include "depth.h"
 #include "position.h"
 #include "value.h"
@@ -34,27 +38,50 @@
 //// Types
 ////
 
-/// The TTEntry class is the class of transposition table entries.
+/// The TTEntry class is the class of transposition table entries. An entry
+/// takes 16 bytes: only the upper 32 bits of the position key are stored,
+/// because the lower bits are implied by the entry's place in the table, and
+/// the space saved holds the static evaluation of the position together with
+/// its extra futility margin, so that the search does not need to evaluate
+/// the position again when it comes back to it.
 
 class TTEntry {
 
 public:
   TTEntry();
-  TTEntry(Key k, Value v, ValueType t, Depth d, Move m, int generation);
-  Key key() const { return key_; }
+  TTEntry(uint32_t k, Value v, ValueType t, Depth d, Move m, int generation,
+          Value statV, Value statM);
+  uint32_t key() const { return key32; }
   Depth depth() const { return Depth(depth_); }
   Move move() const { return Move(data & 0x7FFFF); }
   Value value() const { return Value(value_); }
   ValueType type() const { return ValueType((data >> 20) & 3); }
   int generation() const { return (data >> 23); }
+  Value static_value() const { return Value(staticValue); }
+  Value static_value_margin() const { return Value(staticValueMargin); }
 
 private:
-  Key key_;
+  uint32_t key32;
   uint32_t data;
   int16_t value_;
   int16_t depth_;
+  int16_t staticValue;
+  int16_t staticValueMargin;
+};
+
+
+/// A TTCluster is the group of entries a position can be stored in. The
+/// table is aligned so that every cluster fills exactly one cache line, and
+/// a lookup never touches more than one line.
+
+const int ClusterSize = 4;
+const int CacheLineSize = 64;
+
+struct TTCluster {
+  TTEntry data[ClusterSize];
 };
 
+
 /// The transposition table class.  This is basically just a huge array
 /// containing TTEntry objects, and a few methods for writing new entries
 /// and reading new ones.
@@ -66,18 +93,20 @@ public:
   ~TranspositionTable();
   void set_size(unsigned mbSize);
   void clear();
-  void store(const Position &pos, Value v, Depth d, Move m, ValueType type);
+  void store(const Position &pos, Value v, Depth d, Move m, ValueType type,
+             Value statV = VALUE_NONE, Value statM = Value(0));
   const TTEntry* retrieve(const Position &pos) const;
+  void prefetch(Key posKey) const;
   void new_search();
   void insert_pv(const Position &pos, Move pv[]);
-  int full();
+  int full() const;
 
 private:
-  inline TTEntry* first_entry(const Position &pos) const;
+  TTEntry* first_entry(Key posKey) const;
 
   unsigned size;
-  int writes;
-  TTEntry* entries;
+  char* mem;
+  TTCluster* entries;
   uint8_t generation;
 };
 
@@ -89,5 +118,38 @@ private:
 // Default transposition table size, in megabytes:
 const int TTDefaultSize = 32;
 
+// The main transposition table, defined in search.cpp
+extern TranspositionTable TT;
+
+
+////
+//// Inline functions
+////
+
+/// TranspositionTable::first_entry returns a pointer to the first entry of
+/// the cluster a position with the given key belongs to. The lower bits of
+/// the key select the cluster, the upper 32 bits are checked against the
+/// entries.
+
+inline TTEntry* TranspositionTable::first_entry(Key posKey) const {
+
+  return entries[unsigned(posKey) & (size - 1)].data;
+}
+
+
+/// TranspositionTable::prefetch() asks the CPU to start loading the cluster
+/// of a position into the cache. Position::do_move() calls it as soon as the
+/// key of the new position is known, so that the memory access overlaps with
+/// the rest of the move update instead of stalling the later lookup.
+
+inline void TranspositionTable::prefetch(Key posKey) const {
+
+#if defined(_MSC_VER)
+  _mm_prefetch((char*)first_entry(posKey), _MM_HINT_T0);
+#else
+  __builtin_prefetch(first_entry(posKey));
+#endif
+}
+
 
 #endif // !defined(TT_H_INCLUDED)
@@ -60,6 +60,9 @@ extern void material_alloc    ();
 extern void material_free    ();
 extern void material_clear    (int ThreadId);
 
+extern void material_prefetch (uint64 key, int ThreadId);
+extern void material_stats    ();
+
 extern void material_get_info (material_info_t * info, const board_t * board, int ThreadId);
 
 #endif // !defined MATERIAL_H
@@ -19,16 +19,22 @@
 // constants
 
 static const bool UseTable = true;
-static const uint32 TableSize = 16384; // was 16384 256kB tried 65536 
+
+static const int BucketSize = 4; // 4 * 16 bytes = one cache line
 
 // types
 
 typedef pawn_info_t entry_t;
 
+struct bucket_t {
+   entry_t entry[BucketSize]; // most recent first
+};
+
 struct pawn_t {
-   entry_t * table;
-   uint32 size;
-   uint32 mask;
+   bucket_t * table; // page aligned
+   uint64 bytes;
+   uint32 bucket_nb; // any number, the key is scaled to it
+   bool huge;
    uint32 used;
    sint64 read_nb;
    sint64 read_hit;
@@ -82,7 +88,7 @@ int BitLast[0x100];
 int BitCount[0x100];
 int BitRev[0x100];
 
-static pawn_t Pawn[MaxThreads][1];
+static pawn_t * Pawn[MaxThreads]; // NULL above NumberThreads
 
 static int BitRank1[RankNb];
 static int BitRank2[RankNb];
@@ -90,7 +96,9 @@ static int BitRank3[RankNb];
 
 // prototypes
 
-static void pawn_comp_info (pawn_info_t * info, const board_t * board);
+static void       pawn_comp_info (pawn_info_t * info, const board_t * board);
+
+static bucket_t * pawn_bucket    (const pawn_t * pawn, uint64 key);
 
 // functions
 
@@ -170,7 +178,7 @@ void pawn_parameter() {
 
 void pawn_init() {
 
-   int rank, file, ThreadId;
+   int rank, file;
 
    // UCI options
 
@@ -205,13 +213,7 @@ void pawn_init() {
    //FileBonus[FileG] = 0;
    //FileBonus[FileH] = 0;
 
-   // pawn hash-table
-
-	for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		Pawn[ThreadId]->size = 0;
-		Pawn[ThreadId]->mask = 0;
-		Pawn[ThreadId]->table = NULL;
-	}
+   // pawn hash-tables are allocated per thread in pawn_alloc()
 }
 
 // pawn_alloc()
@@ -220,14 +222,24 @@ void pawn_alloc() {
 	
 	int ThreadId;
 
+   uint64 size;
+
    ASSERT(sizeof(entry_t)==16);
+   ASSERT(sizeof(bucket_t)==64);
 
    if (UseTable) {
+
+      // the "Pawn Hash" option in kB, per thread
+
+      size = (uint64(option_get_int("Pawn Hash")) * 1024) / sizeof(bucket_t);
+      if (size < 1) size = 1;
+      if (size > 0xFFFFFFFF) size = 0xFFFFFFFF;
 		
 		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-			Pawn[ThreadId]->size = TableSize;
-			Pawn[ThreadId]->mask = TableSize - 1;
-			Pawn[ThreadId]->table = (entry_t *) my_malloc(Pawn[ThreadId]->size*sizeof(entry_t));
+			Pawn[ThreadId] = (pawn_t *) my_malloc(sizeof(pawn_t));
+			Pawn[ThreadId]->bucket_nb = (uint32) size;
+			Pawn[ThreadId]->bytes = size * sizeof(bucket_t);
+			Pawn[ThreadId]->table = (bucket_t *) my_large_malloc(Pawn[ThreadId]->bytes,&Pawn[ThreadId]->huge);
 
 			pawn_clear(ThreadId);
 		}
@@ -246,7 +258,9 @@ void pawn_free() {
 		
                 for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
 
-		  my_free(Pawn[ThreadId]->table);
+		  my_large_free(Pawn[ThreadId]->table,Pawn[ThreadId]->bytes);
+		  my_free(Pawn[ThreadId]);
+		  Pawn[ThreadId] = NULL;
 		}
    }
 }
@@ -256,7 +270,7 @@ void pawn_free() {
 void pawn_clear(int ThreadId) {
 
    if (Pawn[ThreadId]->table != NULL) {
-      memset(Pawn[ThreadId]->table,0,Pawn[ThreadId]->size*sizeof(entry_t));
+      memset(Pawn[ThreadId]->table,0,Pawn[ThreadId]->bytes);
    }
 
    Pawn[ThreadId]->used = 0;
@@ -266,12 +280,47 @@ void pawn_clear(int ThreadId) {
    Pawn[ThreadId]->write_collision = 0;
 }
 
+// pawn_prefetch()
+
+void pawn_prefetch(uint64 key, int ThreadId) {
+
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+
+   // called from move_do(), possibly before the tables exist
+
+   if (UseTable && Pawn[ThreadId] != NULL) PREFETCH(pawn_bucket(Pawn[ThreadId],key));
+}
+
+// pawn_stats()
+
+void pawn_stats() {
+
+   int ThreadId;
+   sint64 read_nb, read_hit, write_nb, write_collision;
+
+   if (!UseTable || Pawn[0] == NULL) return;
+
+   read_nb = read_hit = write_nb = write_collision = 0;
+
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+      read_nb += Pawn[ThreadId]->read_nb;
+      read_hit += Pawn[ThreadId]->read_hit;
+      write_nb += Pawn[ThreadId]->write_nb;
+      write_collision += Pawn[ThreadId]->write_collision;
+   }
+
+   send("info string pawn hash " S64_FORMAT " kB x %d hit %.1f%% collision %.1f%%",sint64(Pawn[0]->bytes>>10),NumberThreads,
+        (read_nb==0)?0.0:double(read_hit)*100.0/double(read_nb),(write_nb==0)?0.0:double(write_collision)*100.0/double(write_nb));
+}
+
 // pawn_get_info()
 
 void pawn_get_info(pawn_info_t * info, const board_t * board, int ThreadId) {
 
    uint64 key;
-   entry_t * entry;
+   uint32 lock;
+   bucket_t * bucket;
+   int i;
 
    ASSERT(info!=NULL);
    ASSERT(board!=NULL);
@@ -283,17 +332,21 @@ void pawn_get_info(pawn_info_t * info, const board_t * board, int ThreadId) {
       Pawn[ThreadId]->read_nb++;
 
       key = board->pawn_key;
-      entry = &Pawn[ThreadId]->table[KEY_INDEX(key)&Pawn[ThreadId]->mask];
+      lock = KEY_LOCK(key);
+      bucket = pawn_bucket(Pawn[ThreadId],key);
 
-      if (entry->lock == KEY_LOCK(key)) {
+      for (i = 0; i < BucketSize; i++) {
 
-         // found
+         if (bucket->entry[i].lock == lock) {
 
-         Pawn[ThreadId]->read_hit++;
+            // found
 
-         *info = *entry;
+            Pawn[ThreadId]->read_hit++;
 
-         return;
+            *info = bucket->entry[i];
+
+            return;
+         }
       }
    }
 
@@ -307,17 +360,38 @@ void pawn_get_info(pawn_info_t * info, const board_t * board, int ThreadId) {
 
       Pawn[ThreadId]->write_nb++;
 
-      if (entry->lock == 0) { // HACK: assume free entry
+      if (bucket->entry[BucketSize-1].lock == 0) { // HACK: assume free entry
          Pawn[ThreadId]->used++;
       } else {
          Pawn[ThreadId]->write_collision++;
       }
 
-      *entry = *info;
-      entry->lock = KEY_LOCK(key);
+      // the oldest entry is replaced
+
+      for (i = BucketSize-1; i > 0; i--) bucket->entry[i] = bucket->entry[i-1];
+
+      bucket->entry[0] = *info;
+      bucket->entry[0].lock = lock;
    }
 }
 
+// pawn_bucket()
+
+static bucket_t * pawn_bucket(const pawn_t * pawn, uint64 key) {
+
+   uint32 index;
+
+   ASSERT(pawn!=NULL);
+
+   // scale the lower half of the key to the bucket count, the upper half is the lock
+
+   index = uint32((uint64(KEY_INDEX(key)) * pawn->bucket_nb) >> 32);
+
+   ASSERT(index<pawn->bucket_nb);
+
+   return &pawn->table[index];
+}
+
 // pawn_comp_info()
 
 static void pawn_comp_info(pawn_info_t * info, const board_t * board) {
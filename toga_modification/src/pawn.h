@@ -57,6 +57,9 @@ extern void pawn_alloc    ();
 extern void pawn_free    ();
 extern void pawn_clear    (int ThreadId);
 
+extern void pawn_prefetch (uint64 key, int ThreadId);
+extern void pawn_stats    ();
+
 extern void pawn_get_info (pawn_info_t * info, const board_t * board, int ThreadId);
 
 extern int  quad          (int y_min, int y_max, int x);
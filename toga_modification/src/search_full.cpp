@@ -9,6 +9,7 @@
 #include "board.h"
 #include "colour.h"
 #include "eval.h"
+#include "hash.h"
 #include "list.h"
 #include "move.h"
 #include "move_check.h"
@@ -90,6 +91,14 @@ static int QuietMoveReduction[64][64]; // [depth][played move count][ThreadId]
 
 static const int MoveCountLimit[6] = {0, 4, 7, 12, 19, 28};
 
+// SMP: ABDADA-style deferral of moves another thread is already searching
+
+static const bool UseDefer = true;
+static const int DeferDepth = 4; // shallower subtrees do not pay for the shared-table traffic
+static const int BusySize = 4096; // power of two, 32kB
+
+static volatile uint64 Busy[BusySize]; // lock << 32 | depth << 8 | ThreadId+1, 0 = free
+
 // quiescence search
 
 static /* const */ bool UseDelta = true; // false
@@ -131,8 +140,23 @@ static bool is_passed		     (const board_t * board, int to);
 
 static bool pawn_is_endgame      (int move, const board_t * board);
 
+static bool busy_is_searched     (uint64 key, int depth, int ThreadId);
+static bool busy_enter           (uint64 key, int depth, int ThreadId);
+static void busy_leave           (uint64 key, int depth, int ThreadId);
+
 // functions
 
+// search_full_clear()
+
+void search_full_clear() {
+
+   int i;
+
+   // marks left behind by a stopped search (longjmp) would defer moves nobody searches
+
+   for (i = 0; i < BusySize; i++) Busy[i] = 0;
+}
+
 // search_full_init()
 
 void search_full_init(list_t * list, board_t * board, int ThreadId) {
@@ -322,6 +346,8 @@ static int full_root(list_t * list, board_t * board, int alpha, int beta, int de
 	  //new_depth1 = full_new_depth(depth,move,board,board_is_check(board)&&LIST_SIZE(list)==1,false, height, ThreadId);
 
       move_do(board,move,undo);
+
+      SearchCurrent[ThreadId]->last_move = move; // refutation table and countermove history
       
       // search move. Changed by Jerry Donald to use aspiration windows (no Inf window researches needed)
       if (search_type == SearchShort || best_value[SearchCurrent[ThreadId]->multipv] == ValueNone) { // first move
@@ -409,13 +435,18 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    int last_move;
    int quiet_move_count;
    int depth_margin;
+   int move_value;
+   int deferred_nb, deferred_pos;
    bool reduced, cap_extended;
    bool cut_node;
+   bool smp, marked;
    attack_t attack[1];
    sort_t sort[1];
    undo_t undo[1];
    mv_t new_pv[HeightMax];
    mv_t played[256];
+   mv_t deferred[256];
+   int deferred_value[256];
    entry_t * found_entry;
       
    ASSERT(board!=NULL);
@@ -665,17 +696,40 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    good_cap = true;
    quiet_move_count = 0;
    cut_node = (node_type == NodeCut);
+
+   smp = UseDefer && NumberThreads > 1 && depth >= DeferDepth;
+   deferred_nb = 0;
+   deferred_pos = -1; // first pass
    
-   while ((move=sort_next(sort,ThreadId)) != MoveNone) {
+   while (true) {
+
+      if (deferred_pos < 0) {
+
+         move = sort_next(sort,ThreadId);
+         move_value = sort->value; // history score
+
+         if (move == MoveNone) {
+            deferred_pos = 0; // second pass over the deferred moves, if any
+            continue;
+         }
+
+      } else {
+
+         if (deferred_pos >= deferred_nb) break;
+
+         move = deferred[deferred_pos];
+         move_value = deferred_value[deferred_pos];
+         deferred_pos++;
+      }
 
 	  // extensions
 
       new_depth = full_new_depth(depth,move,board,single_reply,node_type==NodePV, height, extended, &cap_extended, ThreadId);
       
-      // history pruning
+      // history pruning (deferred moves already survived it)
 
-      value = sort->value; // history score
-	  if (!in_check && depth <= 6 && node_type != NodePV 
+      value = move_value;
+	  if (deferred_pos < 0 && !in_check && depth <= 6 && node_type != NodePV 
 		  && new_depth < depth && value < 2 * HistoryValue / (depth + depth % 2)
 		  && played_nb >= 1+depth && !move_is_dangerous(move,board)){ 
 			continue;
@@ -683,7 +737,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
       // quiet move count based pruning (added by Jerry Donald Watson: ~10 elo)
 
-	  if (node_type != NodePV && depth <= 5) {
+	  if (deferred_pos < 0 && node_type != NodePV && depth <= 5) {
 		  
          if (!in_check && new_depth < depth&& !move_is_tactical(move,board) && !move_is_dangerous(move,board)) {
 
@@ -727,6 +781,23 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 	  // recursive search
 
 	  move_do(board,move,undo);
+
+      // ABDADA: the eldest brother is always searched, the others wait if another thread is on them
+
+      if (smp && deferred_pos < 0 && played_nb > 0 && busy_is_searched(board->key,new_depth,ThreadId)) {
+
+         move_undo(board,move,undo);
+
+         deferred[deferred_nb] = move;
+         deferred_value[deferred_nb] = move_value;
+         deferred_nb++;
+
+         SearchCurrent[ThreadId]->defer_nb++;
+
+         continue;
+      }
+
+      marked = smp && busy_enter(board->key,new_depth,ThreadId);
 	  
 	  SearchCurrent[ThreadId]->last_move = move;
 
@@ -760,6 +831,8 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
          }
       }
 
+      if (marked) busy_leave(board->key,new_depth,ThreadId);
+
       move_undo(board,move,undo);
 
       played[played_nb++] = move;
@@ -1322,5 +1395,53 @@ static bool pawn_is_endgame(int move, const board_t * board) {
    
 }
 
+// busy_is_searched()
+
+static bool busy_is_searched(uint64 key, int depth, int ThreadId) {
+
+   uint64 busy;
+
+   ASSERT(depth_is_ok(depth));
+
+   busy = Busy[KEY_INDEX(key)&(BusySize-1)];
+
+   // same position, at least as deep, by another thread
+
+   return busy != 0
+       && uint32(busy >> 32) == KEY_LOCK(key)
+       && int((busy >> 8) & 0xFF) >= depth
+       && int(busy & 0xFF) != ThreadId+1;
+}
+
+// busy_enter()
+
+static bool busy_enter(uint64 key, int depth, int ThreadId) {
+
+   volatile uint64 * busy;
+
+   ASSERT(depth_is_ok(depth));
+
+   busy = &Busy[KEY_INDEX(key)&(BusySize-1)];
+
+   // first come first served, a lost race only costs a redundant search
+
+   if (*busy != 0) return false;
+
+   *busy = (uint64(KEY_LOCK(key)) << 32) | (uint64(MIN(depth,0xFF)) << 8) | uint64(ThreadId+1);
+
+   return true;
+}
+
+// busy_leave()
+
+static void busy_leave(uint64 key, int depth, int ThreadId) {
+
+   volatile uint64 * busy;
+
+   busy = &Busy[KEY_INDEX(key)&(BusySize-1)];
+
+   if (*busy == ((uint64(KEY_LOCK(key)) << 32) | (uint64(MIN(depth,0xFF)) << 8) | uint64(ThreadId+1))) *busy = 0;
+}
+
 // end of search_full.cpp
 
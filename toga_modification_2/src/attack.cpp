@@ -4,6 +4,7 @@
 // includes
 
 #include "attack.h"
+#include "bitboard.h"
 #include "board.h"
 #include "colour.h"
 #include "move.h"
@@ -42,6 +43,10 @@ void attack_init() {
    int from, to;
    int pos;
 
+   // bitboard tables
+
+   BitboardUtils::initializeBitboardAttacks();
+
    // clear
 
    for (delta = 0; delta < DeltaNb; delta++) {
@@ -244,49 +249,60 @@ static void add_attack(int piece, int king, int target) {
 
 bool is_attacked(const board_t * board, int to, int colour) {
 
-   int inc;
-   int pawn;
-   const sq_t * ptr;
-   int from;
-   int piece;
-   int delta;
-   int sq;
+   int to_64;
+   uint64 sliders;
+   uint64 occupied;
 
    ASSERT(board!=NULL);
    ASSERT(SQUARE_IS_OK(to));
    ASSERT(COLOUR_IS_OK(colour));
 
-   // pawn attack
+   to_64 = SQUARE_TO_64(to);
 
-   inc = PAWN_MOVE_INC(colour);
-   pawn = PAWN_MAKE(colour);
+   // pawn attack
 
-   if (board->square[to-(inc-1)] == pawn) return true;
-   if (board->square[to-(inc+1)] == pawn) return true;
+   if ((BitboardUtils::PAWN_ATTACKS[COLOUR_OPP(colour)][to_64] & board->piece_bb[WhitePawn12+colour]) != 0) return true;
 
    // piece attack
 
-   for (ptr = &board->piece[colour][0]; (from=*ptr) != SquareNone; ptr++) {
-
-      piece = board->square[from];
-      delta = to - from;
+   if ((BitboardUtils::KNIGHT_ATTACKS[to_64] & board->piece_bb[WhiteKnight12+colour]) != 0) return true;
+   if ((BitboardUtils::KING_ATTACKS[to_64] & board->piece_bb[WhiteKing12+colour]) != 0) return true;
 
-      if (PSEUDO_ATTACK(piece,delta)) {
+   occupied = BOARD_OCCUPIED(board);
 
-         inc = DELTA_INC_ALL(delta);
-         ASSERT(inc!=IncNone);
+   sliders = board->piece_bb[WhiteBishop12+colour] | board->piece_bb[WhiteQueen12+colour];
+   if (sliders != 0 && (BitboardUtils::bishopAttacks(to_64,occupied) & sliders) != 0) return true;
 
-         sq = from;
-         do {
-            sq += inc;
-            if (sq == to) return true;
-         } while (board->square[sq] == Empty);
-      }
-   }
+   sliders = board->piece_bb[WhiteRook12+colour] | board->piece_bb[WhiteQueen12+colour];
+   if (sliders != 0 && (BitboardUtils::rookAttacks(to_64,occupied) & sliders) != 0) return true;
 
    return false;
 }
 
+// attackers_to()
+
+uint64 attackers_to(const board_t * board, int to, int colour) {
+
+   int to_64;
+   uint64 occupied;
+   uint64 attackers;
+
+   ASSERT(board!=NULL);
+   ASSERT(SQUARE_IS_OK(to));
+   ASSERT(COLOUR_IS_OK(colour));
+
+   to_64 = SQUARE_TO_64(to);
+   occupied = BOARD_OCCUPIED(board);
+
+   attackers = BitboardUtils::PAWN_ATTACKS[COLOUR_OPP(colour)][to_64] & board->piece_bb[WhitePawn12+colour];
+   attackers |= BitboardUtils::KNIGHT_ATTACKS[to_64] & board->piece_bb[WhiteKnight12+colour];
+   attackers |= BitboardUtils::bishopAttacks(to_64,occupied) & (board->piece_bb[WhiteBishop12+colour] | board->piece_bb[WhiteQueen12+colour]);
+   attackers |= BitboardUtils::rookAttacks(to_64,occupied) & (board->piece_bb[WhiteRook12+colour] | board->piece_bb[WhiteQueen12+colour]);
+   attackers |= BitboardUtils::KING_ATTACKS[to_64] & board->piece_bb[WhiteKing12+colour];
+
+   return attackers;
+}
+
 // line_is_empty()
 
 bool line_is_empty(const board_t * board, int from, int to) {
@@ -377,8 +393,8 @@ void attack_set(attack_t * attack, const board_t * board) {
    int from, to;
    int inc;
    int pawn;
-   int delta, piece;
-   int sq;
+   int piece;
+   uint64 attackers;
 
    ASSERT(attack!=NULL);
    ASSERT(board!=NULL);
@@ -392,6 +408,14 @@ void attack_set(attack_t * attack, const board_t * board) {
 
    to = KING_POS(board,me);
 
+   attackers = attackers_to(board,to,opp);
+
+   if (attackers == 0) { // not in check
+      attack->ds[0] = SquareNone;
+      attack->di[0] = IncNone;
+      return;
+   }
+
    // pawn attacks
 
    inc = PAWN_MOVE_INC(opp);
@@ -415,32 +439,20 @@ void attack_set(attack_t * attack, const board_t * board) {
 
    for (ptr = &board->piece[opp][1]; (from=*ptr) != SquareNone; ptr++) { // HACK: no king
 
-      piece = board->square[from];
-
-      delta = to - from;
-      ASSERT(delta_is_ok(delta));
-
-      if (PSEUDO_ATTACK(piece,delta)) {
-
-         inc = IncNone;
-
-         if (PIECE_IS_SLIDER(piece)) {
-
-            // check for blockers
-
-            inc = DELTA_INC_LINE(delta);
-            ASSERT(inc!=IncNone);
+      if ((attackers & SQUARE_BB(from)) == 0) continue; // list order is kept for the evasions
 
-            sq = from;
-            do sq += inc; while (board->square[sq] == Empty);
+      piece = board->square[from];
 
-            if (sq != to) continue; // blocker => next attacker
-         }
+      inc = IncNone;
 
-         attack->ds[attack->dn] = from;
-         attack->di[attack->dn] = -inc; // HACK
-         attack->dn++;
+      if (PIECE_IS_SLIDER(piece)) {
+         inc = DELTA_INC_LINE(to-from);
+         ASSERT(inc!=IncNone);
       }
+
+      attack->ds[attack->dn] = from;
+      attack->di[attack->dn] = -inc; // HACK
+      attack->dn++;
    }
 
    attack->ds[attack->dn] = SquareNone;
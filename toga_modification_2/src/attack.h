@@ -47,6 +47,7 @@ extern int IncMask[IncNb];
 extern void attack_init   ();
 
 extern bool is_attacked   (const board_t * board, int to, int colour);
+extern uint64 attackers_to (const board_t * board, int to, int colour);
 
 extern bool line_is_empty (const board_t * board, int from, int to);
 
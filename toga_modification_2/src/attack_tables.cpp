@@ -10,12 +10,13 @@ namespace BitboardUtils {
     Bitboard PAWN_ATTACKS[2][64];
     
     Bitboard DIAGONAL_MASK[64];
+    Bitboard ANTI_DIAGONAL_MASK[64];
     Bitboard HORIZONTAL_MASK[64];
     Bitboard VERTICAL_MASK[64];
     
-    Bitboard DIAGONAL_ATTACKS[64][512];
-    Bitboard HORIZONTAL_ATTACKS[64][256];
-    Bitboard VERTICAL_ATTACKS[64][256];
+    Bitboard DIAGONAL_ATTACKS[64][128];
+    Bitboard HORIZONTAL_ATTACKS[64][64];
+    Bitboard VERTICAL_ATTACKS[64][64];
 
     // Mask generation functions
     Bitboard generateDiagonalMask(int square) {
@@ -25,7 +26,23 @@ namespace BitboardUtils {
         
         for (int r = 0; r < 8; r++) {
             for (int f = 0; f < 8; f++) {
-                if (abs(r - rank) == abs(f - file)) {
+                if (r - rank == f - file) {
+                    mask |= (1ULL << (r * 8 + f));
+                }
+            }
+        }
+        
+        return mask;
+    }
+
+    Bitboard generateAntiDiagonalMask(int square) {
+        Bitboard mask = 0;
+        int rank = square / 8;
+        int file = square % 8;
+        
+        for (int r = 0; r < 8; r++) {
+            for (int f = 0; f < 8; f++) {
+                if (r - rank == file - f) {
                     mask |= (1ULL << (r * 8 + f));
                 }
             }
@@ -123,17 +140,58 @@ namespace BitboardUtils {
         }
     }
 
-    // Generate slider attack tables (simplified example)
+    // Walk both rays of one line from square up to the first blocker (included)
+    Bitboard slideAttacks(int square, Bitboard occupancy, int rankStep, int fileStep) {
+        Bitboard attacks = 0;
+        int rank = square / 8;
+        int file = square % 8;
+
+        for (int dir = -1; dir <= 1; dir += 2) {
+            int r = rank + dir * rankStep;
+            int f = file + dir * fileStep;
+
+            while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+                Bitboard bit = 1ULL << (r * 8 + f);
+                attacks |= bit;
+                if ((occupancy & bit) != 0) break;
+                r += dir * rankStep;
+                f += dir * fileStep;
+            }
+        }
+
+        return attacks;
+    }
+
+    // Spread an 8-bit line index back over the line squares in mask
+    // (bit i selects the mask square on file i, or on rank i for files)
+    Bitboard lineOccupancy(int index, Bitboard mask, bool byRank) {
+        Bitboard occupancy = 0;
+
+        for (int sq = 0; sq < 64; sq++) {
+            if ((mask & (1ULL << sq)) != 0 && (index & (1 << (byRank ? sq / 8 : sq % 8))) != 0) {
+                occupancy |= 1ULL << sq;
+            }
+        }
+
+        return occupancy;
+    }
+
+    // Generate slider attack tables
     void initializeSliderAttacks() {
         for (int sq = 0; sq < 64; sq++) {
-            // Diagonal attacks
+            // Masks
             DIAGONAL_MASK[sq] = generateDiagonalMask(sq);
-            
-            // Horizontal attacks
+            ANTI_DIAGONAL_MASK[sq] = generateAntiDiagonalMask(sq);
             HORIZONTAL_MASK[sq] = generateHorizontalMask(sq);
-            
-            // Vertical attacks
             VERTICAL_MASK[sq] = generateVerticalMask(sq);
+
+            // Attacks for every occupancy of the six inner squares of each line
+            for (int index = 0; index < 64; index++) {
+                DIAGONAL_ATTACKS[sq][index] = slideAttacks(sq, lineOccupancy(index << 1, DIAGONAL_MASK[sq], false), 1, 1);
+                DIAGONAL_ATTACKS[sq][64 + index] = slideAttacks(sq, lineOccupancy(index << 1, ANTI_DIAGONAL_MASK[sq], false), 1, -1);
+                HORIZONTAL_ATTACKS[sq][index] = slideAttacks(sq, lineOccupancy(index << 1, HORIZONTAL_MASK[sq], false), 0, 1);
+                VERTICAL_ATTACKS[sq][index] = slideAttacks(sq, lineOccupancy(index << 1, VERTICAL_MASK[sq], true), 1, 0);
+            }
         }
     }
 
@@ -145,39 +203,17 @@ namespace BitboardUtils {
         initializeSliderAttacks();
     }
 
-    // Advanced slider attack calculation
+    // Slider attack lookup by piece type (Bishop64, Rook64 or Queen64)
     Bitboard getSliderAttacks(int piece, int square, Bitboard occupancy) {
-        // Implement advanced attack generation based on piece type and occupancy
         switch(piece) {
-            case Bishop64: {
-                // Use diagonal mask and occupancy to generate attacks
-                Bitboard diagonalOccupancy = occupancy & DIAGONAL_MASK[square];
-                // Advanced magic bitboard calculation would go here
-                return 0; // Placeholder
-            }
-            case Rook64: {
-                // Use horizontal and vertical masks
-                Bitboard horizontalOccupancy = occupancy & HORIZONTAL_MASK[square];
-                Bitboard verticalOccupancy = occupancy & VERTICAL_MASK[square];
-                // Advanced magic bitboard calculation would go here
-                return 0; // Placeholder
-            }
-            case Queen64: {
-                // Combine bishop and rook attacks
-                return getSliderAttacks(Bishop64, square, occupancy) | 
-                       getSliderAttacks(Rook64, square, occupancy);
-            }
+            case Bishop64:
+                return bishopAttacks(square, occupancy);
+            case Rook64:
+                return rookAttacks(square, occupancy);
+            case Queen64:
+                return queenAttacks(square, occupancy);
             default:
                 return 0;
         }
     }
-
-    // Utility functions
-    int popCount(Bitboard b) {
-        return __builtin_popcountll(b);  // GCC/Clang intrinsic
-    }
-
-    int bitScanForward(Bitboard b) {
-        return __builtin_ctzll(b);  // GCC/Clang intrinsic
-    }
 }
\ No newline at end of file
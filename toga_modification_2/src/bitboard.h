@@ -5,34 +5,71 @@
 
 using Bitboard = uint64_t;
 
+// Squares are numbered a1 = 0 .. h8 = 63, i.e. SQUARE_TO_64() order.
+//
+// Slider attacks use line-occupancy tables: the occupancy of one line
+// (rank, file, diagonal or anti-diagonal) through the square is folded
+// into a byte with a single multiply, and the six inner bits of that byte
+// index the attacks along the line (the two end squares never block
+// anything).  The fold is exact, so no magic numbers are needed and the
+// tables stay at 128 kB.
+
 namespace BitboardUtils {
+    const Bitboard FILE_A = 0x0101010101010101ULL;
+
+    // (line & mask) * FILE_FOLD gathers one bit per file into the top byte
+    const Bitboard FILE_FOLD = 0x0101010101010101ULL;
+    // (file bits shifted to file a) * RANK_FOLD gathers one bit per rank
+    const Bitboard RANK_FOLD = 0x0102040810204080ULL;
+
     // Precomputed attack tables declarations
     extern Bitboard KNIGHT_ATTACKS[64];
     extern Bitboard KING_ATTACKS[64];
     extern Bitboard PAWN_ATTACKS[2][64];
-    
-    extern Bitboard DIAGONAL_MASK[64];
+
+    extern Bitboard DIAGONAL_MASK[64];      // a1-h8 direction
+    extern Bitboard ANTI_DIAGONAL_MASK[64]; // h1-a8 direction
     extern Bitboard HORIZONTAL_MASK[64];
     extern Bitboard VERTICAL_MASK[64];
-    
-    extern Bitboard DIAGONAL_ATTACKS[64][512];
-    extern Bitboard HORIZONTAL_ATTACKS[64][256];
-    extern Bitboard VERTICAL_ATTACKS[64][256];
+
+    extern Bitboard DIAGONAL_ATTACKS[64][128]; // [0..63] diagonal, [64..127] anti-diagonal, indexed by file
+    extern Bitboard HORIZONTAL_ATTACKS[64][64]; // indexed by file
+    extern Bitboard VERTICAL_ATTACKS[64][64]; // indexed by rank
 
     // Initialization functions
     void initializeBitboardAttacks();
-    
+
     // Mask generation functions
     Bitboard generateDiagonalMask(int square);
+    Bitboard generateAntiDiagonalMask(int square);
     Bitboard generateHorizontalMask(int square);
     Bitboard generateVerticalMask(int square);
 
     // Attack calculation functions
     Bitboard getSliderAttacks(int piece, int square, Bitboard occupancy);
-    
+
+    inline Bitboard bishopAttacks(int square, Bitboard occupancy) {
+        return DIAGONAL_ATTACKS[square][(((occupancy & DIAGONAL_MASK[square]) * FILE_FOLD) >> 57) & 63]
+             | DIAGONAL_ATTACKS[square][64 + ((((occupancy & ANTI_DIAGONAL_MASK[square]) * FILE_FOLD) >> 57) & 63)];
+    }
+
+    inline Bitboard rookAttacks(int square, Bitboard occupancy) {
+        return HORIZONTAL_ATTACKS[square][(occupancy >> ((square & 56) + 1)) & 63]
+             | VERTICAL_ATTACKS[square][((((occupancy >> (square & 7)) & FILE_A) * RANK_FOLD) >> 57) & 63];
+    }
+
+    inline Bitboard queenAttacks(int square, Bitboard occupancy) {
+        return bishopAttacks(square, occupancy) | rookAttacks(square, occupancy);
+    }
+
     // Utility functions
-    int popCount(Bitboard b);
-    int bitScanForward(Bitboard b);
+    inline int popCount(Bitboard b) {
+        return __builtin_popcountll(b);  // GCC/Clang intrinsic
+    }
+
+    inline int bitScanForward(Bitboard b) {
+        return __builtin_ctzll(b);  // GCC/Clang intrinsic
+    }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,7 @@
 // includes
 
 #include "attack.h"
+#include "bitboard.h"
 #include "board.h"
 #include "colour.h"
 #include "fen.h"
@@ -53,10 +54,13 @@ bool board_is_ok(const board_t * board) {
          if (piece == Empty) {
 
             if (pos != -1) return false;
+            if ((BOARD_OCCUPIED(board) & SQUARE_BB(sq)) != 0) return false;
 
          } else {
 
             if (!piece_is_ok(piece)) return false;
+            if ((board->piece_bb[PIECE_TO_12(piece)] & SQUARE_BB(sq)) == 0) return false;
+            if ((board->colour_bb[PIECE_COLOUR(piece)] & SQUARE_BB(sq)) == 0) return false;
 
             if (!PIECE_IS_PAWN(piece)) {
 
@@ -150,6 +154,16 @@ bool board_is_ok(const board_t * board) {
    if (board->number[WhiteKing12] != 1) return false;
    if (board->number[BlackKing12] != 1) return false;
 
+   // bitboards (every piece was found on its bitboards above)
+
+   for (piece = 0; piece < 12; piece++) {
+      if (BitboardUtils::popCount(board->piece_bb[piece]) != board->number[piece]) return false;
+   }
+
+   for (colour = 0; colour < ColourNb; colour++) {
+      if (BitboardUtils::popCount(board->colour_bb[colour]) != board->piece_size[colour] + board->pawn_size[colour]) return false;
+   }
+
    // misc
 
    if (!COLOUR_IS_OK(board->turn)) return false;
@@ -195,6 +209,8 @@ void board_clear(board_t * board) {
    board->flags = FlagsNone;
    board->ep_square = SquareNone;
    board->ply_nb = 0;
+
+   board->thread = 0;
 }
 
 // board_copy()
@@ -229,6 +245,9 @@ void board_init_list(board_t * board) {
    board->piece_nb = 0;
    for (piece = 0; piece < 12; piece++) board->number[piece] = 0;
 
+   for (piece = 0; piece < 12; piece++) board->piece_bb[piece] = 0;
+   for (colour = 0; colour < ColourNb; colour++) board->colour_bb[colour] = 0;
+
    // piece lists
 
    for (colour = 0; colour < ColourNb; colour++) {
@@ -255,6 +274,8 @@ void board_init_list(board_t * board) {
             board->piece_nb++;
             board->number[PIECE_TO_12(piece)]++;
 
+            board->piece_bb[PIECE_TO_12(piece)] |= SQUARE_BB(sq);
+            board->colour_bb[colour] |= SQUARE_BB(sq);
          }
       }
 
@@ -332,6 +353,9 @@ void board_init_list(board_t * board) {
             board->number[PIECE_TO_12(piece)]++;
             board->pawn_file[colour][SQUARE_FILE(sq)] |= BIT(PAWN_RANK(sq,colour));
 
+            board->piece_bb[PIECE_TO_12(piece)] |= SQUARE_BB(sq);
+            board->colour_bb[colour] |= SQUARE_BB(sq);
+
 			board->piece_material[colour] += VALUE_PIECE(piece); // Thomas
          }
       }
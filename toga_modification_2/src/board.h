@@ -42,6 +42,9 @@ const int StackSize = 4096;
 
 #define KING_POS(board,colour) ((board)->piece[colour][0])
 
+#define SQUARE_BB(square)      (U64(1)<<SQUARE_TO_64(square))
+#define BOARD_OCCUPIED(board)  ((board)->colour_bb[White]|(board)->colour_bb[Black])
+
 // types
 
 struct board_t {
@@ -62,6 +65,9 @@ struct board_t {
 
    int pawn_file[ColourNb][FileNb];
 
+   uint64 piece_bb[12]; // indexed by PIECE_TO_12(), a1 = bit 0
+   uint64 colour_bb[ColourNb];
+
    int turn;
    int flags;
    int ep_square;
@@ -78,6 +84,8 @@ struct board_t {
    uint64 pawn_key;
    uint64 material_key;
 
+   int thread; // owner of the per-thread pawn and material tables, for prefetching
+
    uint64 stack[StackSize];
 };
 
@@ -19,7 +19,8 @@
 // constants
 
 static const bool UseTable = true;
-static const uint32 TableSize = 256; // was 256 4kB tried 16384
+
+static const int BucketSize = 4; // 4 * 16 bytes = one cache line
 
 static const int PawnPhase   = 0;
 static const int KnightPhase = 1;
@@ -59,10 +60,15 @@ static /* const */ int RookPawnPenalty = 10;
 
 typedef material_info_t entry_t;
 
+struct bucket_t {
+   entry_t entry[BucketSize]; // most recent first
+};
+
 struct material_t {
-   entry_t * table;
-   uint32 size;
-   uint32 mask;
+   bucket_t * table; // page aligned
+   uint64 bytes;
+   uint32 bucket_nb; // any number, the key is scaled to it
+   bool huge;
    uint32 used;
    sint64 read_nb;
    sint64 read_hit;
@@ -72,11 +78,13 @@ struct material_t {
 
 // variables
 
-static material_t Material[MaxThreads][1];
+static material_t * Material[MaxThreads]; // NULL above NumberThreads
 
 // prototypes
 
-static void material_comp_info (material_info_t * info, const board_t * board);
+static void       material_comp_info (material_info_t * info, const board_t * board);
+
+static bucket_t * material_bucket    (const material_t * material, uint64 key);
 
 // functions
 
@@ -98,19 +106,11 @@ void material_parameter() {
 
 void material_init() {
 
-	int ThreadId;
-
    // UCI options
 
    material_parameter();
 
-   // material table
-
-	for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		Material[ThreadId]->size = 0;
-		Material[ThreadId]->mask = 0;
-		Material[ThreadId]->table = NULL;
-	}
+   // material tables are allocated per thread in material_alloc()
 }
 
 // material_alloc()
@@ -119,14 +119,24 @@ void material_alloc() {
 
 	int ThreadId;
 
+   uint64 size;
+
    ASSERT(sizeof(entry_t)==16);
+   ASSERT(sizeof(bucket_t)==64);
 
    if (UseTable) {
 
+      // the "Material Hash" option in kB, per thread
+
+      size = (uint64(option_get_int("Material Hash")) * 1024) / sizeof(bucket_t);
+      if (size < 1) size = 1;
+      if (size > 0xFFFFFFFF) size = 0xFFFFFFFF;
+
 		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-			Material[ThreadId]->size = TableSize;
-			Material[ThreadId]->mask = TableSize - 1;
-			Material[ThreadId]->table = (entry_t *) my_malloc((uint64) Material[ThreadId]->size*sizeof(entry_t));
+			Material[ThreadId] = (material_t *) my_malloc(sizeof(material_t));
+			Material[ThreadId]->bucket_nb = (uint32) size;
+			Material[ThreadId]->bytes = size * sizeof(bucket_t);
+			Material[ThreadId]->table = (bucket_t *) my_large_malloc(Material[ThreadId]->bytes,&Material[ThreadId]->huge);
 
 			material_clear(ThreadId);
 		}
@@ -144,7 +154,9 @@ void material_free() {
    if (UseTable) {
 
 		for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
-		  my_free(Material[ThreadId]->table);
+		  my_large_free(Material[ThreadId]->table,Material[ThreadId]->bytes);
+		  my_free(Material[ThreadId]);
+		  Material[ThreadId] = NULL;
 		}
    }
 }
@@ -154,7 +166,7 @@ void material_free() {
 void material_clear(int ThreadId) {
 
    if (Material[ThreadId]->table != NULL) {
-      memset(Material[ThreadId]->table,0,Material[ThreadId]->size*sizeof(entry_t));
+      memset(Material[ThreadId]->table,0,Material[ThreadId]->bytes);
    }
 
    Material[ThreadId]->used = 0;
@@ -164,12 +176,47 @@ void material_clear(int ThreadId) {
    Material[ThreadId]->write_collision = 0;
 }
 
+// material_prefetch()
+
+void material_prefetch(uint64 key, int ThreadId) {
+
+   ASSERT(ThreadId>=0&&ThreadId<MaxThreads);
+
+   // called from move_do(), possibly before the tables exist
+
+   if (UseTable && Material[ThreadId] != NULL) PREFETCH(material_bucket(Material[ThreadId],key));
+}
+
+// material_stats()
+
+void material_stats() {
+
+   int ThreadId;
+   sint64 read_nb, read_hit, write_nb, write_collision;
+
+   if (!UseTable || Material[0] == NULL) return;
+
+   read_nb = read_hit = write_nb = write_collision = 0;
+
+   for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+      read_nb += Material[ThreadId]->read_nb;
+      read_hit += Material[ThreadId]->read_hit;
+      write_nb += Material[ThreadId]->write_nb;
+      write_collision += Material[ThreadId]->write_collision;
+   }
+
+   send("info string material hash " S64_FORMAT " kB x %d hit %.1f%% collision %.1f%%",sint64(Material[0]->bytes>>10),NumberThreads,
+        (read_nb==0)?0.0:double(read_hit)*100.0/double(read_nb),(write_nb==0)?0.0:double(write_collision)*100.0/double(write_nb));
+}
+
 // material_get_info()
 
 void material_get_info(material_info_t * info, const board_t * board, int ThreadId) {
 
    uint64 key;
-   entry_t * entry;
+   uint32 lock;
+   bucket_t * bucket;
+   int i;
 
    ASSERT(info!=NULL);
    ASSERT(board!=NULL);
@@ -181,17 +228,21 @@ void material_get_info(material_info_t * info, const board_t * board, int Thread
       Material[ThreadId]->read_nb++;
 
       key = board->material_key;
-      entry = &Material[ThreadId]->table[KEY_INDEX(key)&Material[ThreadId]->mask];
+      lock = KEY_LOCK(key);
+      bucket = material_bucket(Material[ThreadId],key);
+
+      for (i = 0; i < BucketSize; i++) {
 
-      if (entry->lock == KEY_LOCK(key)) {
+         if (bucket->entry[i].lock == lock) {
 
-         // found
+            // found
 
-         Material[ThreadId]->read_hit++;
+            Material[ThreadId]->read_hit++;
 
-         *info = *entry;
+            *info = bucket->entry[i];
 
-         return;
+            return;
+         }
       }
    }
 
@@ -205,17 +256,38 @@ void material_get_info(material_info_t * info, const board_t * board, int Thread
 
       Material[ThreadId]->write_nb++;
 
-      if (entry->lock == 0) { // HACK: assume free entry
+      if (bucket->entry[BucketSize-1].lock == 0) { // HACK: assume free entry
          Material[ThreadId]->used++;
       } else {
          Material[ThreadId]->write_collision++;
       }
 
-      *entry = *info;
-      entry->lock = KEY_LOCK(key);
+      // the oldest entry is replaced
+
+      for (i = BucketSize-1; i > 0; i--) bucket->entry[i] = bucket->entry[i-1];
+
+      bucket->entry[0] = *info;
+      bucket->entry[0].lock = lock;
    }
 }
 
+// material_bucket()
+
+static bucket_t * material_bucket(const material_t * material, uint64 key) {
+
+   uint32 index;
+
+   ASSERT(material!=NULL);
+
+   // scale the lower half of the key to the bucket count, the upper half is the lock
+
+   index = uint32((uint64(KEY_INDEX(key)) * material->bucket_nb) >> 32);
+
+   ASSERT(index<material->bucket_nb);
+
+   return &material->table[index];
+}
+
 // material_comp_info()
 
 static void material_comp_info(material_info_t * info, const board_t * board) {
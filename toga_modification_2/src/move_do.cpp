@@ -7,12 +7,14 @@
 #include "board.h"
 #include "colour.h"
 #include "hash.h"
+#include "material.h"
 #include "move.h"
 #include "move_do.h"
 #include "pawn.h" // TODO: bit.h
 #include "piece.h"
 #include "pst.h"
 #include "random.h"
+#include "trans.h"
 #include "util.h"
 #include "value.h"
 
@@ -213,6 +215,12 @@ void move_do(board_t * board, int move, undo_t * undo) {
       }
    }
 
+   // prefetch the hash entries of the new position, eval and the next probe come soon
+
+   trans_prefetch(Trans,board->key);
+   if (board->pawn_key != undo->pawn_key) pawn_prefetch(board->pawn_key,board->thread);
+   if (board->material_key != undo->material_key) material_prefetch(board->material_key,board->thread);
+
    // debug
 
    ASSERT(board_is_ok(board));
@@ -363,6 +371,10 @@ void move_do_null(board_t * board, undo_t * undo) {
    board->cap_sq = SquareNone;
 	board->moving_piece = PieceNone256;
 
+   // prefetch the hash entry of the new position
+
+   trans_prefetch(Trans,board->key);
+
    // debug
 
    ASSERT(board_is_ok(board));
@@ -425,6 +437,12 @@ static void square_clear(board_t * board, int square, int piece, bool update) {
    ASSERT(board->square[square]==piece);
    board->square[square] = Empty;
 
+   // bitboards
+
+   ASSERT((board->piece_bb[piece_12]&SQUARE_BB(square))!=0);
+   board->piece_bb[piece_12] ^= SQUARE_BB(square);
+   board->colour_bb[colour] ^= SQUARE_BB(square);
+
    // piece list
 
    if (!PIECE_IS_PAWN(piece)) {
@@ -554,6 +572,12 @@ static void square_set(board_t * board, int square, int piece, int pos, bool upd
    ASSERT(board->square[square]==Empty);
    board->square[square] = piece;
 
+   // bitboards
+
+   ASSERT((BOARD_OCCUPIED(board)&SQUARE_BB(square))==0);
+   board->piece_bb[piece_12] ^= SQUARE_BB(square);
+   board->colour_bb[colour] ^= SQUARE_BB(square);
+
    // piece list
 
    if (!PIECE_IS_PAWN(piece)) {
@@ -670,6 +694,7 @@ static void square_move(board_t * board, int from, int to, int piece, bool updat
    int from_64, to_64;
    int piece_12;
    int piece_index;
+   uint64 bb;
    uint64 hash_xor;
 
    ASSERT(board!=NULL);
@@ -701,6 +726,13 @@ static void square_move(board_t * board, int from, int to, int piece, bool updat
    ASSERT(board->pos[to]==-1);
    board->pos[to] = pos;
 
+   // bitboards
+
+   bb = SQUARE_BB(from) | SQUARE_BB(to);
+
+   board->piece_bb[PIECE_TO_12(piece)] ^= bb;
+   board->colour_bb[colour] ^= bb;
+
    // piece list
 
    if (!PIECE_IS_PAWN(piece)) {
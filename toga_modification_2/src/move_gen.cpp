@@ -4,6 +4,7 @@
 // includes
 
 #include "attack.h"
+#include "bitboard.h"
 #include "board.h"
 #include "colour.h"
 #include "list.h"
@@ -18,6 +19,7 @@
 
 static void add_moves               (list_t * list, const board_t * board);
 static void add_captures            (list_t * list, const board_t * board);
+static void add_slider_captures     (list_t * list, int from, uint64 targets);
 static void add_quiet_moves         (list_t * list, const board_t * board);
 
 static void add_promotes            (list_t * list, const board_t * board);
@@ -191,10 +193,12 @@ static void add_moves(list_t * list, const board_t * board) {
 static void add_captures(list_t * list, const board_t * board) {
 
    int me, opp;
-   int opp_flag;
    const sq_t * ptr;
    int from, to;
-   int piece, capture;
+   int from_64;
+   int piece;
+   uint64 targets, occupied;
+   uint64 attacks;
 
    ASSERT(list!=NULL);
    ASSERT(board!=NULL);
@@ -202,196 +206,113 @@ static void add_captures(list_t * list, const board_t * board) {
    me = board->turn;
    opp = COLOUR_OPP(me);
 
-   opp_flag = COLOUR_FLAG(opp);
+   targets = board->colour_bb[opp];
+   occupied = BOARD_OCCUPIED(board);
 
    // piece captures
 
    for (ptr = &board->piece[me][0]; (from=*ptr) != SquareNone; ptr++) {
 
       piece = board->square[from];
+      from_64 = SQUARE_TO_64(from);
 
       switch (PIECE_TYPE(piece)) {
 
       case Knight64:
-
-         to = from - 33;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 31;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 18;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 14;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 14;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 18;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 31;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 33;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
+         attacks = BitboardUtils::KNIGHT_ATTACKS[from_64];
          break;
 
       case Bishop64:
-
-         for (to = from-17; (capture=board->square[to]) == Empty; to -= 17)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from-15; (capture=board->square[to]) == Empty; to -= 15)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+15; (capture=board->square[to]) == Empty; to += 15)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+17; (capture=board->square[to]) == Empty; to += 17)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
+         attacks = BitboardUtils::bishopAttacks(from_64,occupied);
          break;
 
       case Rook64:
-
-         for (to = from-16; (capture=board->square[to]) == Empty; to -= 16)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from-1; (capture=board->square[to]) == Empty; to -= 1)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+1; (capture=board->square[to]) == Empty; to += 1)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+16; (capture=board->square[to]) == Empty; to += 16)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
+         attacks = BitboardUtils::rookAttacks(from_64,occupied);
          break;
 
       case Queen64:
-
-         for (to = from-17; (capture=board->square[to]) == Empty; to -= 17)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from-16; (capture=board->square[to]) == Empty; to -= 16)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from-15; (capture=board->square[to]) == Empty; to -= 15)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from-1; (capture=board->square[to]) == Empty; to -= 1)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+1; (capture=board->square[to]) == Empty; to += 1)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+15; (capture=board->square[to]) == Empty; to += 15)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+16; (capture=board->square[to]) == Empty; to += 16)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         for (to = from+17; (capture=board->square[to]) == Empty; to += 17)
-            ;
-         if (FLAG_IS(capture,opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
+         attacks = BitboardUtils::queenAttacks(from_64,occupied);
          break;
 
       case King64:
-
-         to = from - 17;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 16;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 15;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from - 1;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 1;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 15;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 16;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
-         to = from + 17;
-         if (FLAG_IS(board->square[to],opp_flag)) LIST_ADD(list,MOVE_MAKE(from,to));
-
+         attacks = BitboardUtils::KING_ATTACKS[from_64];
          break;
 
       default:
 
          ASSERT(false);
+         attacks = 0;
          break;
       }
+
+      attacks &= targets;
+
+      if (PIECE_IS_SLIDER(piece) && (attacks & (attacks - 1)) != 0) {
+         add_slider_captures(list,from,attacks);
+         continue;
+      }
+
+      for (; attacks != 0; attacks &= attacks - 1) {
+         to = SQUARE_FROM_64(BitboardUtils::bitScanForward(attacks));
+         LIST_ADD(list,MOVE_MAKE(from,to));
+      }
    }
 
    // pawn captures
 
-   if (COLOUR_IS_WHITE(me)) {
-
-      for (ptr = &board->pawn[me][0]; (from=*ptr) != SquareNone; ptr++) {
+   for (ptr = &board->pawn[me][0]; (from=*ptr) != SquareNone; ptr++) {
 
-         to = from + 15;
-         if (FLAG_IS(board->square[to],opp_flag)) add_pawn_move(list,from,to);
+      attacks = BitboardUtils::PAWN_ATTACKS[me][SQUARE_TO_64(from)] & targets;
 
-         to = from + 17;
-         if (FLAG_IS(board->square[to],opp_flag)) add_pawn_move(list,from,to);
+      for (; attacks != 0; attacks &= attacks - 1) {
+         to = SQUARE_FROM_64(BitboardUtils::bitScanForward(attacks));
+         add_pawn_move(list,from,to);
+      }
 
-         // promote
+      // promote
 
-         if (SQUARE_RANK(from) == Rank7) {
-            to = from + 16;
-            if (board->square[to] == Empty) {
-               add_promote(list,MOVE_MAKE(from,to));
-            }
+      if (PAWN_RANK(from,me) == Rank7) {
+         to = from + PAWN_MOVE_INC(me);
+         if (board->square[to] == Empty) {
+            add_promote(list,MOVE_MAKE(from,to));
          }
       }
+   }
+}
 
-   } else { // black
+// add_slider_captures()
 
-      for (ptr = &board->pawn[me][0]; (from=*ptr) != SquareNone; ptr++) {
+static void add_slider_captures(list_t * list, int from, uint64 targets) {
 
-         to = from - 17;
-         if (FLAG_IS(board->square[to],opp_flag)) add_pawn_move(list,from,to);
+   int to_list[8];
+   int size, pos;
+   int to, inc;
 
-         to = from - 15;
-         if (FLAG_IS(board->square[to],opp_flag)) add_pawn_move(list,from,to);
+   ASSERT(list!=NULL);
+   ASSERT(SQUARE_IS_OK(from));
+   ASSERT(targets!=0);
 
-         // promote
+   // one target per ray, emitted in increasing inc order like the former ray walk
+   // (bit order would reshuffle equal MVV/LVA captures and change the search)
 
-         if (SQUARE_RANK(from) == Rank2) {
-            to = from - 16;
-            if (board->square[to] == Empty) {
-               add_promote(list,MOVE_MAKE(from,to));
-            }
-         }
+   size = 0;
+
+   for (; targets != 0; targets &= targets - 1) {
+
+      to = SQUARE_FROM_64(BitboardUtils::bitScanForward(targets));
+      inc = DELTA_INC_LINE(to-from);
+      ASSERT(inc!=IncNone);
+
+      for (pos = size; pos > 0 && DELTA_INC_LINE(to_list[pos-1]-from) > inc; pos--) {
+         to_list[pos] = to_list[pos-1];
       }
+
+      to_list[pos] = to;
+      size++;
+   }
+
+   for (pos = 0; pos < size; pos++) {
+      LIST_ADD(list,MOVE_MAKE(from,to_list[pos]));
    }
 }
 
@@ -222,7 +222,9 @@ bool pseudo_is_legal(int move, board_t * board) {
       if (DEBUG) {
          ASSERT(board->square[from]==piece);
          board->square[from] = Empty;
+         board->colour_bb[me] ^= SQUARE_BB(from);
          ASSERT(legal==!is_attacked(board,to,opp));
+         board->colour_bb[me] ^= SQUARE_BB(from);
          board->square[from] = piece;
       }
 
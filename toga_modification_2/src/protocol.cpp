@@ -25,9 +25,9 @@
 #include "protocol.h"
 #include "pst.h"
 #include "search.h"
+#include "sort.h"
 #include "trans.h"
 #include "util.h"
-//#include "sort.h"
 //#include "probe.h"
 
 // constants
@@ -37,6 +37,17 @@
 static const double NormalRatio = 1.0;
 static const double PonderRatio = 1.25;
 
+static const int BenchDepth = 12;
+static const int BenchThreads = 32;
+
+static const char * const BenchFen[] = {
+   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+   "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+   NULL,
+};
+
 // variables
 
 #ifdef _WIN32
@@ -59,10 +70,13 @@ static bool Delay; // postpone "bestmove" in infinite/ponder mode?
 static void init              ();
 static void loop_step         ();
 
+static void parse_bench       (char string[]);
 static void parse_go          (char string[]);
 static void parse_position    (char string[]);
 static void parse_setoption   (char string[]);
 
+static void set_threads       (int threads);
+
 static void send_best_move    ();
 
 static bool string_equal      (const char s1[], const char s2[]);
@@ -115,6 +129,9 @@ static void init() {
 
       NumberThreads=option_get_int("Number of Threads");
       if(NumberThreads>MaxThreads) NumberThreads=MaxThreads;
+
+      search_alloc();
+      sort_alloc();
 		
       book_parameter();
       
@@ -167,6 +184,15 @@ static void loop_step() {
 
    if (false) {
 
+   } else if (string_start_with(string,"bench")) {
+
+      if (!Searching && !Delay) {
+         init();
+         parse_bench(string);
+      } else {
+         ASSERT(false);
+      }
+
    } else if (string_start_with(string,"debug ")) {
 
       // dummy
@@ -276,6 +302,106 @@ static void loop_step() {
    }
 }
 
+// parse_bench()
+
+static void parse_bench(char string[]) {
+
+   const char * ptr;
+   int depth, max_threads, threads, old_threads;
+   int pos;
+   int ThreadId;
+   double time, time_1, speed, speed_1;
+   sint64 node_nb, defer_nb;
+
+   // "bench [depth [threads]]", time to depth and speed at 1, 2, 4 ... threads
+
+   depth = BenchDepth;
+   max_threads = BenchThreads;
+
+   ptr = strtok(string," "); // skip "bench"
+
+   ptr = strtok(NULL," ");
+   if (ptr != NULL) depth = atoi(ptr);
+   if (depth < 1) depth = 1;
+   if (depth > DepthMax-1) depth = DepthMax-1;
+
+   ptr = strtok(NULL," ");
+   if (ptr != NULL) max_threads = atoi(ptr);
+   if (max_threads < 1) max_threads = 1;
+   if (max_threads > MaxThreads) max_threads = MaxThreads;
+
+   old_threads = NumberThreads;
+   book_close(); // search() would play book moves
+
+   time_1 = 0.0;
+   speed_1 = 0.0;
+
+   for (threads = 1; threads <= max_threads; threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2) {
+
+      set_threads(threads);
+
+      time = 0.0;
+      node_nb = 0;
+      defer_nb = 0;
+
+      for (pos = 0; BenchFen[pos] != NULL; pos++) {
+
+         // same start for every thread count
+
+         board_from_fen(SearchInput->board,BenchFen[pos]);
+
+         trans_clear(Trans);
+
+         for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++) {
+            sort_init(ThreadId);
+            pawn_clear(ThreadId);
+            material_clear(ThreadId);
+         }
+
+         search_clear();
+
+         SearchInput->depth_is_limited = true;
+         SearchInput->depth_limit = depth;
+
+         Searching = true;
+         Infinite = false;
+         Delay = false;
+
+         search();
+         for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
+            search_update_current(ThreadId);
+         }
+
+         Searching = false;
+
+         time += SearchCurrent[0]->time;
+
+         for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
+            node_nb += SearchCurrent[ThreadId]->node_nb;
+            defer_nb += SearchCurrent[ThreadId]->defer_nb;
+         }
+      }
+
+      speed = (time >= 0.001) ? double(node_nb) / time : 0.0;
+
+      if (threads == 1) {
+         time_1 = time;
+         speed_1 = speed;
+      }
+
+      send("info string bench threads %d depth %d time %.0f nodes " S64_FORMAT " nps %.0f deferred " S64_FORMAT " time-to-depth x%.2f nps x%.2f",
+           threads,depth,time*1000.0,node_nb,speed,defer_nb,(time>=0.001)?time_1/time:0.0,(speed_1>0.0)?speed/speed_1:0.0);
+
+      if (threads == max_threads) break;
+   }
+
+   set_threads(old_threads);
+   book_parameter();
+
+   search_clear();
+   board_from_fen(SearchInput->board,StartFen);
+}
+
 // parse_go()
 
 static void parse_go(char string[]) {
@@ -593,21 +719,52 @@ static void parse_setoption(char string[]) {
       }
    }
    
+   // update evaluation-cache sizes if needed
+
+   if (Init && my_string_equal(name,"Pawn Hash")) { // Init => already allocated
+
+      ASSERT(!Searching);
+
+      pawn_free();
+      pawn_alloc();
+   }
+
+   if (Init && my_string_equal(name,"Material Hash")) { // Init => already allocated
+
+      ASSERT(!Searching);
+
+      material_free();
+      material_alloc();
+   }
+
    if (Init && my_string_equal(name,"Number of Threads")) { // Init => already started
      
      ASSERT(!Searching);
      
-     if (option_get_int("Number of Threads")!= NumberThreads) {
-       exit_threads();
-       pawn_free();
-       material_free();
-       NumberThreads=option_get_int("Number of Threads");
-       if(NumberThreads>MaxThreads) NumberThreads=MaxThreads;
-       pawn_alloc();
-       material_alloc();
-       search_clear();
-       start_suspend_threads();
-     }
+     set_threads(option_get_int("Number of Threads"));
+   }
+}
+
+// set_threads()
+
+static void set_threads(int threads) {
+
+   ASSERT(Init);
+   ASSERT(!Searching);
+
+   if (threads > MaxThreads) threads = MaxThreads;
+
+   if (threads != NumberThreads) {
+      exit_threads();
+      pawn_free();
+      material_free();
+      NumberThreads = threads;
+      search_alloc();
+      sort_alloc();
+      pawn_alloc();
+      material_alloc();
+      search_clear();
+      start_suspend_threads();
    }
 }
 
@@ -642,8 +799,19 @@ static void send_best_move() {
    send("info time %.0f nodes " S64_FORMAT " nps %.0f cpuload %.0f",time*1000.0,node_nb,speed,cpu*1000.0);
 
    trans_stats(Trans);
-   // pawn_stats();
-   // material_stats();
+#if STATS
+   pawn_stats();
+   material_stats();
+   sort_stats();
+
+   if (NumberThreads > 1) {
+      node_nb = 0;
+      for (ThreadId = 0; ThreadId < NumberThreads; ThreadId++){
+         node_nb += SearchCurrent[ThreadId]->defer_nb;
+      }
+      send("info string abdada " S64_FORMAT " moves deferred",node_nb);
+   }
+#endif
 
    // best move
 
@@ -107,18 +107,28 @@ struct search_current_t {
    bool trans_reduction;
    bool do_nullmove;
    sint64 node_nb;
+   sint64 defer_nb; // moves left to another thread (ABDADA)
    double time;
    double speed;
    double cpu;
 };
 
+// per-thread search state, one allocation per configured thread
+
+struct search_thread_t {
+   search_info_t info[1];
+   search_current_t current[1];
+   search_root_t root[1];
+   search_best_t best[MultiPVMax];
+};
+
 // variables
 
 extern search_input_t SearchInput[1];
-extern search_info_t SearchInfo[MaxThreads][1];
-extern search_best_t SearchBest[MaxThreads][MultiPVMax];
-extern search_root_t SearchRoot[MaxThreads][1];
-extern search_current_t SearchCurrent[MaxThreads][1];
+extern search_info_t * SearchInfo[MaxThreads];
+extern search_best_t * SearchBest[MaxThreads];
+extern search_root_t * SearchRoot[MaxThreads];
+extern search_current_t * SearchCurrent[MaxThreads];
 extern int NumberThreads;
 
 // functions
@@ -126,6 +136,7 @@ extern int NumberThreads;
 extern bool depth_is_ok           (int depth);
 extern bool height_is_ok          (int height);
 
+extern void search_alloc          ();
 extern void search_clear          ();
 extern void search                ();
 extern void search_smp            (int ThreadId);
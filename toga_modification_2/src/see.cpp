@@ -247,37 +247,27 @@ static void alist_build(alist_t * alist, const board_t * board, int to, int colo
 
    const sq_t * ptr;
    int from;
-   int piece;
-   int delta;
    int inc;
-   int sq;
    int pawn;
+   uint64 attackers;
 
    ASSERT(alist!=NULL);
    ASSERT(board!=NULL);
    ASSERT(SQUARE_IS_OK(to));
    ASSERT(COLOUR_IS_OK(colour));
 
-   // piece attacks
-
-   for (ptr = &board->piece[colour][0]; (from=*ptr) != SquareNone; ptr++) {
+   attackers = attackers_to(board,to,colour);
+   if (attackers == 0) return;
 
-      piece = board->square[from];
-      delta = to - from;
+   // piece attacks (in list order, which alist_add() keeps for equal pieces)
 
-      if (PSEUDO_ATTACK(piece,delta)) {
+   attackers &= ~board->piece_bb[WhitePawn12+colour];
 
-         inc = DELTA_INC_ALL(delta);
-         ASSERT(inc!=IncNone);
+   for (ptr = &board->piece[colour][0]; attackers != 0 && (from=*ptr) != SquareNone; ptr++) {
 
-         sq = from;
-         do {
-            sq += inc;
-            if (sq == to) { // attack
-               alist_add(alist,from,board);
-               break;
-            }
-         } while (board->square[sq] == Empty);
+      if ((attackers & SQUARE_BB(from)) != 0) {
+         alist_add(alist,from,board);
+         attackers ^= SQUARE_BB(from);
       }
    }
 
@@ -12,9 +12,22 @@
 #include <cstring>
 #include <ctime>
 
+#if defined(_WIN32) || defined(_WIN64)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 #include "posix.h"
 #include "util.h"
 
+// constants
+
+static const uint64 HugePageSize = 2 * 1024 * 1024; // x86 Linux
+
 // functions
 
 // util_init()
@@ -86,6 +99,152 @@ void my_free(void * address) {
    free(address);
 }
 
+// my_large_malloc()
+
+void * my_large_malloc(uint64 size, bool * huge) {
+
+   void * address;
+
+   ASSERT(size>0);
+   ASSERT(huge!=NULL);
+
+   *huge = false;
+
+#if defined(_WIN32) || defined(_WIN64)
+
+   // large pages need the "Lock pages in memory" privilege, else fall back
+
+   SIZE_T large = GetLargePageMinimum();
+
+   if (large != 0 && size % large == 0) {
+      address = VirtualAlloc(NULL,size,MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES,PAGE_READWRITE);
+      if (address != NULL) {
+         *huge = true;
+         return address;
+      }
+   }
+
+   address = VirtualAlloc(NULL,size,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE);
+   if (address == NULL) my_fatal("my_large_malloc(): VirtualAlloc(): error %d\n",int(GetLastError()));
+
+#else
+
+   // reserved huge pages if any, else ask for transparent ones
+
+#  ifdef MAP_HUGETLB
+   if (size % HugePageSize == 0) {
+      address = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+      if (address != MAP_FAILED) {
+         *huge = true;
+         return address;
+      }
+   }
+#  endif
+
+   address = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+   if (address == MAP_FAILED) my_fatal("my_large_malloc(): mmap(): %s\n",strerror(errno));
+
+#  ifdef MADV_HUGEPAGE
+   if (size >= HugePageSize) madvise(address,size,MADV_HUGEPAGE);
+#  endif
+
+#endif
+
+   return address;
+}
+
+// my_large_free()
+
+void my_large_free(void * address, uint64 size) {
+
+   ASSERT(address!=NULL);
+   ASSERT(size>0);
+
+#if defined(_WIN32) || defined(_WIN64)
+   VirtualFree(address,0,MEM_RELEASE);
+#else
+   munmap(address,size);
+#endif
+}
+
+// my_file_map()
+
+const void * my_file_map(const char file_name[], uint64 * size) {
+
+   void * address;
+
+   ASSERT(file_name!=NULL);
+   ASSERT(size!=NULL);
+
+   // read-only shared mapping, NULL if the file is missing or empty
+
+   *size = 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+
+   HANDLE file, mapping;
+   LARGE_INTEGER file_size;
+
+   file = CreateFileA(file_name,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_RANDOM_ACCESS,NULL);
+   if (file == INVALID_HANDLE_VALUE) return NULL;
+
+   if (!GetFileSizeEx(file,&file_size) || file_size.QuadPart == 0) {
+      CloseHandle(file);
+      return NULL;
+   }
+
+   mapping = CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+   CloseHandle(file);
+   if (mapping == NULL) my_fatal("my_file_map(): CreateFileMapping(): error %d\n",int(GetLastError()));
+
+   address = MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+   CloseHandle(mapping); // the view keeps the mapping alive
+   if (address == NULL) my_fatal("my_file_map(): MapViewOfFile(): error %d\n",int(GetLastError()));
+
+   *size = file_size.QuadPart;
+
+#else
+
+   int fd;
+   struct stat st;
+
+   fd = open(file_name,O_RDONLY);
+   if (fd == -1) return NULL;
+
+   if (fstat(fd,&st) == -1 || st.st_size == 0) {
+      close(fd);
+      return NULL;
+   }
+
+   address = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+   close(fd); // the mapping keeps the file open
+   if (address == MAP_FAILED) my_fatal("my_file_map(): mmap(): %s\n",strerror(errno));
+
+#  ifdef MADV_RANDOM
+   madvise(address,st.st_size,MADV_RANDOM); // probes touch a few pages only, no read-ahead
+#  endif
+
+   *size = st.st_size;
+
+#endif
+
+   return address;
+}
+
+// my_file_unmap()
+
+void my_file_unmap(const void * address, uint64 size) {
+
+   ASSERT(address!=NULL);
+   ASSERT(size>0);
+
+#if defined(_WIN32) || defined(_WIN64)
+   UnmapViewOfFile(address);
+#else
+   munmap((void *) address,size);
+#endif
+}
+
 // my_fatal()
 
 void my_fatal(const char format[], ...) {
@@ -8,6 +8,10 @@
 
 #include <cstdio>
 
+#if defined(_MSC_VER) && !defined(__MINGW32__)
+#  include <xmmintrin.h>
+#endif
+
 // constants
 
 #undef FALSE
@@ -23,6 +27,15 @@
 #  define DEBUG FALSE
 #endif
 
+// search statistics after each bestmove (-DSTATS)
+
+#ifdef STATS
+#  undef STATS
+#  define STATS TRUE
+#else
+#  define STATS FALSE
+#endif
+
 #ifdef _MSC_VER
 #  define S64_FORMAT "%I64d"
 #  define U64_FORMAT "%016I64X"
@@ -41,6 +54,14 @@
 #  define U64(u) (u##ULL)
 #endif
 
+#if defined(_MSC_VER) && !defined(__MINGW32__)
+#  define PREFETCH(address) _mm_prefetch((const char *)(address),_MM_HINT_T0)
+#elif defined(__GNUC__)
+#  define PREFETCH(address) __builtin_prefetch((address))
+#else
+#  define PREFETCH(address)
+#endif
+
 #undef ASSERT
 #if DEBUG
 #  define ASSERT(a) { if (!(a)) my_fatal("file \"%s\", line %d, assertion \"" #a "\" failed\n",__FILE__,__LINE__); }
@@ -98,6 +119,12 @@ extern int    my_round              (double x);
 extern void * my_malloc             (uint64 size);
 extern void   my_free               (void * address);
 
+extern void * my_large_malloc       (uint64 size, bool * huge);
+extern void   my_large_free         (void * address, uint64 size);
+
+extern const void * my_file_map     (const char file_name[], uint64 * size);
+extern void   my_file_unmap         (const void * address, uint64 size);
+
 extern void   my_fatal              (const char format[], ...);
 
 extern bool   my_file_read_line     (FILE * file, char string[], int size);